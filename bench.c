@@ -0,0 +1,396 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "command.h"
+#include "game.h"
+#include "message.h"
+#include "socket.h"
+
+#define THROUGHPUT_MESSAGES 100000
+#define LATENCY_ROUND_TRIPS 20000
+#define BOARD_SAMPLES 1024
+#define CPU_ROUNDS 2000
+
+// Message sizes to benchmark, up to the largest frame receive_message accepts
+static const size_t message_sizes[] = {1, 16, 64, 256, 1024, MAX_MESSAGE_LENGTH};
+
+// Inputs for the command parser: valid moves, padding, commands, and garbage
+static const char* parse_inputs[] = {
+    "1 2", "3 3", "  2   1", "1\t3", "quit", "hint", "evaluate", "12 x", "", "2", "-1 4", "99999999999 1", "1 2 extra",
+};
+
+// Results are accumulated here so the compiler cannot drop the benchmarked calls
+static volatile long sink;
+
+// Read a fine-grained timestamp: the cycle counter where there is one, nanoseconds otherwise
+static uint64_t cycles_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CYCLE_UNIT "cycles"
+#else
+#define CYCLE_UNIT "ns"
+#endif
+
+static uint64_t nanoseconds_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Build a message of the given size
+static char* make_message(size_t size) {
+    char* message = malloc(size + 1);
+    memset(message, 'm', size);
+    message[size] = '\0';
+    return message;
+}
+
+/**
+ * Arguments for a thread on the far end of a socketpair.
+ * - fd: The socket to use
+ * - size: The message size to send
+ * - count: The number of messages to send
+ */
+typedef struct {
+    int fd;
+    size_t size;
+    int count;
+} PeerArgs;
+
+// Send a fixed number of messages as fast as possible
+static void* run_sender(void* arg) {
+    PeerArgs* args = arg;
+    char* message = make_message(args->size);
+    for (int i = 0; i < args->count; i++) {
+        if (send_message(args->fd, message)) break;
+    }
+    free(message);
+    return NULL;
+}
+
+// Send every message back until the connection closes
+static void* run_echo(void* arg) {
+    PeerArgs* args = arg;
+    char* message;
+    while ((message = receive_message(args->fd)) != NULL) {
+        int rc = send_message(args->fd, message);
+        free(message);
+        if (rc) break;
+    }
+    return NULL;
+}
+
+/**
+ * Measure how many messages per second one thread can send to another over a
+ * socketpair with send_message and receive_message.
+ */
+static void bench_framing_throughput(size_t size) {
+    int fds[2];
+    if (socket_pair_open(fds)) {
+        perror("socketpair");
+        return;
+    }
+
+    PeerArgs args = {.fd = fds[1], .size = size, .count = THROUGHPUT_MESSAGES};
+    pthread_t sender;
+    uint64_t start = nanoseconds_now();
+    pthread_create(&sender, NULL, run_sender, &args);
+
+    int received = 0;
+    for (; received < THROUGHPUT_MESSAGES; received++) {
+        char* message = receive_message(fds[0]);
+        if (message == NULL) break;
+        sink += message[0];
+        free(message);
+    }
+    uint64_t elapsed = nanoseconds_now() - start;
+    pthread_join(sender, NULL);
+    close(fds[0]);
+    close(fds[1]);
+
+    double seconds = elapsed / 1e9;
+    printf("  %6zu bytes: %10.0f msgs/sec %10.1f MB/sec\n", size, received / seconds,
+           received * (size + sizeof(size_t)) / seconds / 1e6);
+}
+
+/**
+ * Bounce messages off an echo thread on the far end of a connection and record
+ * the round-trip time of each. Shuts the connection down when done.
+ *
+ * \param fds A connected pair of sockets; the echo thread uses fds[1]
+ * \param size The message size to send
+ * \param samples Filled in with round-trip times in nanoseconds
+ * \param cpu_time Set to the CPU time used by the whole process, in nanoseconds
+ * \return The number of round trips completed
+ */
+static int time_round_trips(int fds[2], size_t size, uint64_t* samples, uint64_t* cpu_time) {
+    PeerArgs args = {.fd = fds[1]};
+    pthread_t echo;
+    pthread_create(&echo, NULL, run_echo, &args);
+
+    char* message = make_message(size);
+    struct timespec cpu_start, cpu_end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+
+    int count = 0;
+    for (; count < LATENCY_ROUND_TRIPS; count++) {
+        uint64_t start = nanoseconds_now();
+        if (send_message(fds[0], message)) break;
+        char* reply = receive_message(fds[0]);
+        if (reply == NULL) break;
+        samples[count] = nanoseconds_now() - start;
+        free(reply);
+    }
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    *cpu_time = (cpu_end.tv_sec - cpu_start.tv_sec) * 1000000000ull + cpu_end.tv_nsec - cpu_start.tv_nsec;
+
+    // Closing our end makes the echo thread's receive fail so it exits
+    shutdown(fds[0], SHUT_RDWR);
+    pthread_join(echo, NULL);
+    free(message);
+    return count;
+}
+
+// Print the average, median, and 99th percentile of a set of round-trip times
+static void print_round_trips(const char* label, uint64_t* samples, int count, uint64_t cpu_time) {
+    if (count == 0) return;
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) total += samples[i];
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    printf("  %-14s avg %8.2f us  p50 %8.2f us  p99 %8.2f us  cpu %8.2f us\n", label, total / 1e3 / count,
+           samples[count / 2] / 1e3, samples[count * 99 / 100] / 1e3, cpu_time / 1e3 / count);
+}
+
+/**
+ * Measure the round-trip time of a message bounced off an echo thread over a
+ * socketpair.
+ */
+static void bench_framing_latency(size_t size) {
+    int fds[2];
+    if (socket_pair_open(fds)) {
+        perror("socketpair");
+        return;
+    }
+
+    uint64_t* samples = malloc(LATENCY_ROUND_TRIPS * sizeof(uint64_t));
+    uint64_t cpu_time;
+    int count = time_round_trips(fds, size, samples, &cpu_time);
+    close(fds[0]);
+    close(fds[1]);
+
+    char label[32];
+    snprintf(label, sizeof(label), "%zu bytes:", size);
+    print_round_trips(label, samples, count, cpu_time);
+    free(samples);
+}
+
+/**
+ * Connect to a listening socket from this process and accept the connection,
+ * giving a connected pair like socketpair does.
+ *
+ * \param server_fd A bound server socket
+ * \param connect_to Connects a new client socket to the server
+ * \param fds Set to the client end and the accepted server end
+ * \return 0 on success, -1 on failure
+ */
+static int connect_pair(int server_fd, int (*connect_to)(void), int fds[2]) {
+    if (server_fd == -1 || listen(server_fd, 1)) return -1;
+    fds[0] = connect_to();
+    if (fds[0] == -1) return -1;
+    fds[1] = server_socket_accept(server_fd);
+    if (fds[1] == -1) {
+        close(fds[0]);
+        return -1;
+    }
+    return 0;
+}
+
+static unsigned short tcp_port;
+static char unix_path[64];
+
+static int connect_ipv4(void) {
+    return socket_connect("127.0.0.1", tcp_port);
+}
+
+static int connect_ipv6(void) {
+    return socket_connect("::1", tcp_port);
+}
+
+static int connect_unix(void) {
+    return unix_socket_connect(unix_path);
+}
+
+/**
+ * Compare the transports a player can connect through, with a move-sized
+ * message: TCP over IPv4 and IPv6 loopback, a Unix domain socket, and an
+ * in-process socketpair.
+ */
+static void bench_transports(void) {
+    const size_t size = 64;
+    uint64_t* samples = malloc(LATENCY_ROUND_TRIPS * sizeof(uint64_t));
+    uint64_t cpu_time;
+    int fds[2];
+
+    tcp_port = 0;
+    int tcp_fd = server_socket_open(&tcp_port);
+    if (connect_pair(tcp_fd, connect_ipv4, fds) == 0) {
+        int count = time_round_trips(fds, size, samples, &cpu_time);
+        print_round_trips("TCP IPv4:", samples, count, cpu_time);
+        close(fds[0]);
+        close(fds[1]);
+    } else {
+        printf("  %-14s unavailable\n", "TCP IPv4:");
+    }
+
+    if (connect_pair(tcp_fd, connect_ipv6, fds) == 0) {
+        int count = time_round_trips(fds, size, samples, &cpu_time);
+        print_round_trips("TCP IPv6:", samples, count, cpu_time);
+        close(fds[0]);
+        close(fds[1]);
+    } else {
+        printf("  %-14s unavailable\n", "TCP IPv6:");
+    }
+    if (tcp_fd != -1) close(tcp_fd);
+
+    snprintf(unix_path, sizeof(unix_path), "/tmp/tictactoe_bench_%d.sock", (int)getpid());
+    int unix_fd = unix_socket_open(unix_path);
+    if (connect_pair(unix_fd, connect_unix, fds) == 0) {
+        int count = time_round_trips(fds, size, samples, &cpu_time);
+        print_round_trips("Unix socket:", samples, count, cpu_time);
+        close(fds[0]);
+        close(fds[1]);
+    } else {
+        printf("  %-14s unavailable\n", "Unix socket:");
+    }
+    if (unix_fd != -1) close(unix_fd);
+    unlink(unix_path);
+
+    if (socket_pair_open(fds) == 0) {
+        int count = time_round_trips(fds, size, samples, &cpu_time);
+        print_round_trips("socketpair:", samples, count, cpu_time);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    free(samples);
+}
+
+/**
+ * Measure check_winner on a mix of boards taken from random games at every
+ * stage: empty, in progress, won, and drawn.
+ */
+static void bench_check_winner(void) {
+    static char boards[BOARD_SAMPLES][BOARD_SIZE][BOARD_SIZE];
+    unsigned int seed = 12345;
+
+    for (int i = 0; i < BOARD_SAMPLES; i++) {
+        GameSession game;
+        game_init(&game, i, -1, "X", -1, "O");
+        int stop_after = rand_r(&seed) % (BOARD_SIZE * BOARD_SIZE + 1);
+        for (int moves = 0; moves < stop_after; moves++) {
+            int cell = rand_r(&seed) % (BOARD_SIZE * BOARD_SIZE);
+            MoveResult result = game_play_move(&game, cell / BOARD_SIZE, cell % BOARD_SIZE);
+            if (result == MOVE_WIN || result == MOVE_DRAW) break;
+            if (result == MOVE_OK) game.current_turn = 1 - game.current_turn;
+        }
+        memcpy(boards[i], game.board, sizeof(game.board));
+    }
+
+    long total = 0;
+    uint64_t start = cycles_now();
+    for (int round = 0; round < CPU_ROUNDS; round++) {
+        for (int i = 0; i < BOARD_SAMPLES; i++) total += check_winner(boards[i]);
+    }
+    uint64_t elapsed = cycles_now() - start;
+    sink += total;
+
+    printf("  check_winner: %8.2f %s/call\n", (double)elapsed / ((double)CPU_ROUNDS * BOARD_SAMPLES), CYCLE_UNIT);
+}
+
+// The way handle_game parsed moves before parse_command, kept as a baseline: a check
+// for "quit", then sscanf. It knew no other commands, so "hint" falls through to sscanf.
+static int sscanf_parse_move(const char* move, int* row, int* col) {
+    if (strcmp(move, "quit") == 0) return 1;
+    return sscanf(move, "%d %d", row, col) == 2;
+}
+
+// Measure parse_command and the old sscanf parsing on each sample input
+static void bench_parse_move(void) {
+    int input_count = sizeof(parse_inputs) / sizeof(parse_inputs[0]);
+    printf("  %-16s %14s %14s\n", "input", "sscanf", "parse_command");
+    for (int i = 0; i < input_count; i++) {
+        long total = 0;
+        uint64_t start = cycles_now();
+        for (int round = 0; round < CPU_ROUNDS * 100; round++) {
+            int row = 0, col = 0;
+            total += sscanf_parse_move(parse_inputs[i], &row, &col) + row + col;
+        }
+        uint64_t sscanf_elapsed = cycles_now() - start;
+
+        start = cycles_now();
+        for (int round = 0; round < CPU_ROUNDS * 100; round++) {
+            Command command;
+            total += parse_command(parse_inputs[i], &command) + command.row + command.col;
+        }
+        uint64_t parser_elapsed = cycles_now() - start;
+        sink += total;
+
+        char label[32];
+        snprintf(label, sizeof(label), "\"%s\"", parse_inputs[i]);
+        printf("  %-16s %7.2f %-6s %7.2f %-6s\n", label, (double)sscanf_elapsed / (CPU_ROUNDS * 100), CYCLE_UNIT,
+               (double)parser_elapsed / (CPU_ROUNDS * 100), CYCLE_UNIT);
+    }
+}
+
+/**
+ * Run every benchmark and print the results. Run this before and after a change
+ * to the message framing, transports, win detection, or command parsing to check for regressions.
+ */
+int main() {
+    // A peer thread that exits early should fail our sends, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    int size_count = sizeof(message_sizes) / sizeof(message_sizes[0]);
+
+    printf("Message framing throughput (socketpair, %d messages):\n", THROUGHPUT_MESSAGES);
+    for (int i = 0; i < size_count; i++) bench_framing_throughput(message_sizes[i]);
+
+    printf("Message framing round-trip latency (socketpair, %d round trips):\n", LATENCY_ROUND_TRIPS);
+    for (int i = 0; i < size_count; i++) bench_framing_latency(message_sizes[i]);
+
+    printf("Transport round-trip latency (%d round trips of 64 bytes, cpu is per round trip):\n", LATENCY_ROUND_TRIPS);
+    bench_transports();
+
+    printf("Win detection:\n");
+    bench_check_winner();
+
+    printf("Command parsing (per call):\n");
+    bench_parse_move();
+
+    return 0;
+}
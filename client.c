@@ -1,21 +1,27 @@
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 
 
+#include "command.h"
 #include "message.h"
 #include "socket.h"
 
+// Written to by the receiving thread when the server closes the connection, to wake the input loop
+static int disconnect_pipe[2];
+
 /**
  * Runs in a separate thread on the client side.
- * It continuously waits for messages from the server and prints them.
- * If the server connection closes or the server sends a "Game is Over" message,
- * this thread stops and closes the socket.
+ * It continuously waits for messages from the server and prints them, through
+ * any number of games, until the server closes the connection. Then this thread
+ * wakes the main thread's input loop so the client can shut down.
  *
  * \param arg A pointer to the socket file descriptor
- * \return NULL when the thread finishes
+ * \return NULL when the connection closes
  */
 void* receive_messages(void* arg) {
     int socket_fd = *(int*)arg;
@@ -24,53 +30,350 @@ void* receive_messages(void* arg) {
         // Wait for a message from the server
         char* message = receive_message(socket_fd);
         if (!message) {
-            // If no message is received, the server likely disconnected
-            printf("Game is Over.\n");
+            // If no message is received, the server closed the connection
+            printf("Disconnected from the server.\n");
             break;
         }
 
         // Print the received message
         printf("%s\n", message);
 
-        // Check if the message indicates the game has ended
+        // Free the message after use
+        free(message);
+    }
+
+    // Tell the input loop that the server is gone
+    write(disconnect_pipe[1], "", 1);
+    return NULL;
+}
+
+/**
+ * A queue of server messages waiting to be printed. In scripted mode the
+ * network loop hands messages to a separate render thread through this queue,
+ * so a slow terminal or pipe never delays the next move.
+ */
+typedef struct RenderItem {
+    char* message;  // NULL tells the render thread to stop
+    struct RenderItem* next;
+} RenderItem;
+
+static RenderItem* render_head = NULL;
+static RenderItem* render_tail = NULL;
+static pthread_mutex_t render_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t render_ready = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Add a message to the render queue. The render thread frees it once printed.
+ *
+ * \param message The message to print, or NULL to stop the render thread
+ */
+static void render_push(char* message) {
+    RenderItem* item = malloc(sizeof(RenderItem));
+    item->message = message;
+    item->next = NULL;
+
+    pthread_mutex_lock(&render_mutex);
+    if (render_tail) {
+        render_tail->next = item;
+    } else {
+        render_head = item;
+    }
+    render_tail = item;
+    pthread_cond_signal(&render_ready);
+    pthread_mutex_unlock(&render_mutex);
+}
+
+/**
+ * Runs in a separate thread in scripted mode, printing queued messages in order
+ * until it is handed NULL.
+ *
+ * \param arg Unused
+ * \return NULL when the thread finishes
+ */
+static void* render_messages(void* arg) {
+    while (1) {
+        pthread_mutex_lock(&render_mutex);
+        while (render_head == NULL) pthread_cond_wait(&render_ready, &render_mutex);
+        RenderItem* item = render_head;
+        render_head = item->next;
+        if (render_head == NULL) render_tail = NULL;
+        pthread_mutex_unlock(&render_mutex);
+
+        char* message = item->message;
+        free(item);
+        if (message == NULL) break;
+
+        printf("%s\n", message);
+        free(message);
+    }
+    fflush(stdout);
+    return NULL;
+}
+
+/**
+ * The round-trip time of one scripted line: from sending it to receiving the
+ * server's first message in reply.
+ */
+typedef struct {
+    int game;          // The game the line was sent in, or the game just finished for lobby lines
+    int move;          // The move's number within its game, or 0 for lines that are not moves
+    const char* kind;  // "name", "move", "command" for other in-game commands, or "lobby"
+    double rtt_us;
+    char line[32];
+} MoveTiming;
+
+static int compare_timings(const void* a, const void* b) {
+    double x = ((const MoveTiming*)a)->rtt_us, y = ((const MoveTiming*)b)->rtt_us;
+    return (x > y) - (x < y);
+}
+
+static double microseconds_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Server messages that end with ':' are prompts waiting for the player's input
+static int is_prompt(const char* message) {
+    size_t len = strlen(message);
+    while (len > 0 && (message[len - 1] == ' ' || message[len - 1] == '\n')) len--;
+    return len > 0 && message[len - 1] == ':';
+}
+
+/**
+ * Read the next line to send from a script, skipping blank lines and comments
+ * (lines starting with '#').
+ *
+ * \return Non-zero if a line was read into buffer, 0 at the end of the script
+ */
+static int next_script_line(FILE* script, char* buffer, int size) {
+    while (fgets(buffer, size, script) != NULL) {
+        buffer[strcspn(buffer, "\r\n")] = '\0';
+        if (buffer[0] != '\0' && buffer[0] != '#') return 1;
+    }
+    return 0;
+}
+
+/**
+ * Play from a script instead of the keyboard. The first line is the player's
+ * name and every following line is a command, sent as soon as the server
+ * prompts for one. Games follow one another on the same connection for as long
+ * as the server keeps prompting and the script has lines left. The round-trip
+ * time of every line is recorded and summarized at the end, separately for
+ * moves, other in-game commands, lobby answers, and the player's name.
+ *
+ * \param socket_fd The connected socket
+ * \param script The script to read lines from
+ * \param timings If not NULL, each line's round-trip time is written here as CSV
+ * \param quiet Non-zero to skip printing server messages
+ * \return EXIT_SUCCESS if the script ran to the end, EXIT_FAILURE otherwise
+ */
+static int run_script(int socket_fd, FILE* script, FILE* timings, int quiet) {
+    pthread_t render_thread;
+    if (pthread_create(&render_thread, NULL, render_messages, NULL) != 0) {
+        perror("Failed to create render thread");
+        return EXIT_FAILURE;
+    }
+
+    MoveTiming* records = NULL;
+    int record_count = 0, record_capacity = 0;
+    int games_finished = 0, move_in_game = 0, in_lobby = 0;
+    int sent_name = 0, script_done = 0, failed = 0;
+    double sent_at = -1;  // When the last line was sent, or -1 if no reply is pending
+    MoveTiming pending;   // The record for the last line sent, completed when its reply arrives
+    char line[256];
+
+    while (1) {
+        // Wait for a message from the server
+        char* message = receive_message(socket_fd);
+        if (!message) {
+            // The server closed the connection. That is only expected once the script is used up.
+            if (!script_done && next_script_line(script, line, sizeof(line))) {
+                fprintf(stderr, "Server closed the connection before the script finished\n");
+                failed = 1;
+            }
+            break;
+        }
+        double received_at = microseconds_now();
+
+        // Record how long the server took to answer the last line
+        if (sent_at >= 0) {
+            if (record_count == record_capacity) {
+                record_capacity = record_capacity ? record_capacity * 2 : 64;
+                records = realloc(records, record_capacity * sizeof(MoveTiming));
+            }
+            pending.rtt_us = received_at - sent_at;
+            records[record_count++] = pending;
+            sent_at = -1;
+        }
+
+        int prompt = is_prompt(message);
+
+        // Lines answering the lobby's prompts after a game are recorded as lobby lines
+        if (prompt) in_lobby = strcmp(message, LOBBY_PROMPT_REMATCH) == 0 || strcmp(message, LOBBY_PROMPT) == 0;
         if (strstr(message, "Game is Over") != NULL) {
+            games_finished++;
+            move_in_game = 0;
+        }
+
+        // Hand the message off for printing
+        if (quiet) {
             free(message);
+        } else {
+            render_push(message);
+        }
+
+        if (!prompt) continue;
+
+        // The server is waiting on us: send the next line right away
+        if (!next_script_line(script, line, sizeof(line))) {
+            script_done = 1;
             break;
         }
 
-        // Free the message after use
-        free(message);
+        pending.game = games_finished + 1;
+        pending.move = 0;
+        pending.kind = "name";
+        if (sent_name) {
+            Command command;
+            ParseError error = parse_command(line, &command);
+            if (error != PARSE_OK) {
+                fprintf(stderr, "Script line \"%s\" is not a command (%s at character %d)\n", line,
+                        parse_error_message(error), command.error_offset + 1);
+                failed = 1;
+                break;
+            }
+
+            // Only moves are numbered. Lines answering the lobby belong to the game that just finished.
+            if (in_lobby) {
+                pending.game = games_finished;
+                pending.kind = "lobby";
+            } else if (command.type == COMMAND_MOVE) {
+                pending.move = ++move_in_game;
+                pending.kind = "move";
+            } else {
+                pending.kind = "command";
+            }
+        }
+        sent_name = 1;
+        snprintf(pending.line, sizeof(pending.line), "%s", line);
+
+        sent_at = microseconds_now();
+        if (send_message(socket_fd, line) == -1) {
+            perror("Failed to send message");
+            failed = 1;
+            break;
+        }
     }
 
-    // Close the socket and exit the thread when done
-    close(socket_fd);
-    exit(EXIT_SUCCESS);
+    // Let the render thread print everything still queued, then stop it
+    render_push(NULL);
+    pthread_join(render_thread, NULL);
+
+    if (timings) {
+        fprintf(timings, "game,move,kind,line,rtt_us\n");
+        for (int i = 0; i < record_count; i++) {
+            // Lines that are not moves leave the move column empty
+            char move[16] = "";
+            if (records[i].move > 0) snprintf(move, sizeof(move), "%d", records[i].move);
+            fprintf(timings, "%d,%s,%s,\"%s\",%.1f\n", records[i].game, move, records[i].kind, records[i].line,
+                    records[i].rtt_us);
+        }
+    }
+
+    fprintf(stderr, "Script finished: %d games, %d lines sent\n", games_finished, record_count);
+
+    // Summarize each kind of line on its own. Moves are what the server answers
+    // directly; the name and lobby lines also wait on matchmaking or the opponent.
+    qsort(records, record_count, sizeof(MoveTiming), compare_timings);
+    const char* kinds[] = {"move", "command", "lobby", "name"};
+    for (int k = 0; k < 4; k++) {
+        double total = 0, p50 = 0, p99 = 0, max = 0;
+        int count = 0, seen = 0;
+        for (int i = 0; i < record_count; i++) {
+            if (strcmp(records[i].kind, kinds[k]) == 0) count++;
+        }
+        if (count == 0) continue;
+
+        // The records are sorted by time, so a kind's percentiles can be read off in one pass
+        for (int i = 0; i < record_count; i++) {
+            if (strcmp(records[i].kind, kinds[k]) != 0) continue;
+            if (seen == count / 2) p50 = records[i].rtt_us;
+            if (seen == count * 99 / 100) p99 = records[i].rtt_us;
+            total += records[i].rtt_us;
+            max = records[i].rtt_us;
+            seen++;
+        }
+        fprintf(stderr, "Round trip, %s x%d: avg %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                kinds[k], count, total / count, p50, p99, max);
+    }
+
+    free(records);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /**
  * The main function for the client:
- * 1. Connects to the server using the given hostname and port
- * 2. Receives a welcome message and sends the player's name
- * 3. Creates a receiving thread to listen for server messages continuously
- * 4. The main thread handles user input for moves (or quitting)
+ * 1. Connects to the server using the given hostname and port, or a Unix domain socket path
+ * 2. With "--script <file>" (or "-" for standard input), plays from the script and exits (see run_script)
+ * 3. Otherwise, receives a welcome message and sends the player's name
+ * 4. Creates a receiving thread to listen for server messages continuously
+ * 5. The main thread handles user input for moves (or quitting)
  *
+ * Scripted mode also accepts "--timings <file>" to save per-line round-trip times
+ * as CSV, and "--quiet" to skip printing server messages.
  *
  * \param argc Argument count
- * \param argv Argument vector (argv[1] = server_name, argv[2] = port)
+ * \param argv Argument vector: options, then server_name and port, or "unix:<path>"
  * \return 0 on successful completion
  */
 int main(int argc, char** argv) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <server name> <port>\n", argv[0]);
-        exit(EXIT_FAILURE);
+    const char* program = argv[0];
+    const char* script_path = NULL;
+    const char* timings_path = NULL;
+    int quiet = 0;
+
+    // Read options until the first argument that is not one
+    while (argc > 1 && strncmp(argv[1], "--", 2) == 0) {
+        if (strcmp(argv[1], "--quiet") == 0) {
+            quiet = 1;
+            argc--;
+            argv++;
+        } else if (argc > 2 && strcmp(argv[1], "--script") == 0) {
+            script_path = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (argc > 2 && strcmp(argv[1], "--timings") == 0) {
+            timings_path = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
     }
 
-    // Parse server name and port from command line arguments
-    char* server_name = argv[1];
-    unsigned short port = (unsigned short)atoi(argv[2]);
+    // A server name of "unix:<path>" connects through a Unix domain socket and takes no port.
+    // The timing and quiet options only apply to scripts.
+    int is_unix = (argc == 2 && strncmp(argv[1], "unix:", 5) == 0);
+    int script_only = (script_path == NULL && (timings_path != NULL || quiet));
+    if ((argc != 3 && !is_unix) || script_only) {
+        fprintf(stderr,
+                "Usage: %s [--script <file> [--timings <file>] [--quiet]] <server name> <port>\n"
+                "       %s [--script <file> [--timings <file>] [--quiet]] unix:<socket path>\n",
+                program, program);
+        exit(EXIT_FAILURE);
+    }
 
     // Attempt to connect to the server
-    int socket_fd = socket_connect(server_name, port);
+    int socket_fd;
+    if (is_unix) {
+        socket_fd = unix_socket_connect(argv[1] + 5);
+    } else {
+        // Parse server name and port from command line arguments
+        char* server_name = argv[1];
+        unsigned short port = (unsigned short)atoi(argv[2]);
+        socket_fd = socket_connect(server_name, port);
+    }
     if (socket_fd == -1) {
         perror("Failed to connect to server");
         exit(EXIT_FAILURE);
@@ -78,6 +381,27 @@ int main(int argc, char** argv) {
 
     printf("Successfully Connection Established\n");
 
+    if (script_path != NULL) {
+        FILE* script = (strcmp(script_path, "-") == 0) ? stdin : fopen(script_path, "r");
+        if (script == NULL) {
+            perror("Failed to open script");
+            close(socket_fd);
+            exit(EXIT_FAILURE);
+        }
+        FILE* timings = NULL;
+        if (timings_path != NULL && (timings = fopen(timings_path, "w")) == NULL) {
+            perror("Failed to open timings file");
+            close(socket_fd);
+            exit(EXIT_FAILURE);
+        }
+
+        int status = run_script(socket_fd, script, timings, quiet);
+        if (timings) fclose(timings);
+        if (script != stdin) fclose(script);
+        close(socket_fd);
+        return status;
+    }
+
     // Receive the initial welcome message and instructions from the server
     char* welcome_message = receive_message(socket_fd);
     if (welcome_message) {
@@ -97,6 +421,11 @@ int main(int argc, char** argv) {
     send_message(socket_fd, buffer);
 
     // Create a separate thread to handle incoming messages from the server
+    if (pipe(disconnect_pipe) == -1) {
+        perror("Failed to create pipe");
+        close(socket_fd);
+        exit(EXIT_FAILURE);
+    }
     pthread_t receive_thread;
     if (pthread_create(&receive_thread, NULL, receive_messages, &socket_fd) != 0) {
         perror("Failed to create receive thread");
@@ -105,13 +434,30 @@ int main(int argc, char** argv) {
     }
 
     // The main thread now handles user inputs for moves.
-    // Players type moves like "1 2" or "quit" to exit.
+    // Players type moves like "1 2", "rematch" or "play again" after a game, or "quit" to exit.
+    // Input is read unbuffered so that poll sees exactly what fgets has yet to read.
+    setvbuf(stdin, NULL, _IONBF, 0);
+    struct pollfd inputs[2] = {
+        {.fd = STDIN_FILENO, .events = POLLIN},
+        {.fd = disconnect_pipe[0], .events = POLLIN},
+    };
     while (1) {
+        // Wait for the player to type something, or for the server to disconnect
+        if (poll(inputs, 2, -1) == -1) continue;
+        if (inputs[1].revents) break;
         if (fgets(buffer, sizeof(buffer), stdin) == NULL) break;
 
         // Remove trailing newline
         buffer[strcspn(buffer, "\n")] = '\0';
 
+        // Catch malformed input here instead of waiting on the server to reject it
+        Command command;
+        ParseError error = parse_command(buffer, &command);
+        if (error != PARSE_OK) {
+            printf("Invalid input (%s at character %d). Try again.\n", parse_error_message(error), command.error_offset + 1);
+            continue;
+        }
+
         // Send the player’s input (move or command) to the server
         if (send_message(socket_fd, buffer) == -1) {
             perror("Failed to send message");
@@ -119,13 +465,17 @@ int main(int argc, char** argv) {
         }
 
         // If the player types "quit", print a confirmation and break out of loop
-        if (strcmp(buffer, "quit") == 0) {
+        if (command.type == COMMAND_QUIT) {
             printf("You quit the game. Game is Over.\n");
             break;
         }
     }
 
-    // Close the socket and end the client program
+    // Stop the receiving thread if it is still waiting on the server, then clean up
+    shutdown(socket_fd, SHUT_RDWR);
+    pthread_join(receive_thread, NULL);
+    close(disconnect_pipe[0]);
+    close(disconnect_pipe[1]);
     close(socket_fd);
     return 0;
 }
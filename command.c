@@ -0,0 +1,198 @@
+#include "command.h"
+
+#include <string.h>
+
+/**
+ * A command word and what it parses to.
+ * - word: The lowercase command word
+ * - length: strlen(word)
+ * - type: The command it names
+ * - takes_game_id: Non-zero if a game ID may follow the word
+ * - second_word: A word that must follow for two-word commands, or NULL
+ */
+typedef struct {
+    const char* word;
+    int length;
+    CommandType type;
+    int takes_game_id;
+    const char* second_word;
+} CommandWord;
+
+static const CommandWord command_words[] = {
+    {"quit", 4, COMMAND_QUIT, 0, NULL},
+    {"hint", 4, COMMAND_HINT, 0, NULL},
+    {"evaluate", 8, COMMAND_HINT, 0, NULL},
+    {"spectate", 8, COMMAND_SPECTATE, 1, NULL},
+    {"stats", 5, COMMAND_STATS, 0, NULL},
+    {"resume", 6, COMMAND_RESUME, 1, NULL},
+    {"rematch", 7, COMMAND_REMATCH, 0, NULL},
+    {"play", 4, COMMAND_PLAY_AGAIN, 0, "again"},
+};
+
+// Longer words cannot be commands, so there is no need to look at more letters
+#define MAX_WORD_LENGTH 8
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int is_letter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/**
+ * Read an unsigned decimal number starting at input[*pos] and advance *pos past it.
+ *
+ * \return PARSE_OK, PARSE_EXPECTED_NUMBER, or PARSE_NUMBER_TOO_LARGE. On error,
+ *         *pos is left at the offending character.
+ */
+static ParseError read_number(const char* input, int* pos, int* value) {
+    int p = *pos;
+    if (!is_digit(input[p])) return PARSE_EXPECTED_NUMBER;
+
+    int result = 0;
+    int digits = 0;
+    while (is_digit(input[p])) {
+        if (++digits > COMMAND_MAX_DIGITS) {
+            *pos = p;
+            return PARSE_NUMBER_TOO_LARGE;
+        }
+        result = result * 10 + (input[p] - '0');
+        p++;
+    }
+
+    *pos = p;
+    *value = result;
+    return PARSE_OK;
+}
+
+// Parse a line of player input in a single pass.
+ParseError parse_command(const char* input, Command* command) {
+    memset(command, 0, sizeof(Command));
+    int pos = 0;
+    ParseError error;
+
+    while (is_space(input[pos])) pos++;
+
+    if (input[pos] == '\0') {
+        command->error_offset = pos;
+        return PARSE_EMPTY;
+    }
+
+    if (is_digit(input[pos])) {
+        // A move: row, whitespace, column
+        command->type = COMMAND_MOVE;
+        if ((error = read_number(input, &pos, &command->row)) != PARSE_OK) {
+            command->error_offset = pos;
+            return error;
+        }
+
+        int separator = pos;
+        while (is_space(input[pos])) pos++;
+        if (input[pos] == '\0') {
+            command->error_offset = pos;
+            return PARSE_MISSING_COLUMN;
+        }
+        if (pos == separator) {
+            command->error_offset = pos;
+            return PARSE_EXPECTED_NUMBER;
+        }
+
+        if ((error = read_number(input, &pos, &command->col)) != PARSE_OK) {
+            command->error_offset = pos;
+            return error;
+        }
+    } else if (is_letter(input[pos])) {
+        // A command word, lowercased as it is read
+        int start = pos;
+        char word[MAX_WORD_LENGTH];
+        int length = 0;
+        while (is_letter(input[pos])) {
+            if (length == MAX_WORD_LENGTH) {
+                command->error_offset = start;
+                return PARSE_UNKNOWN_COMMAND;
+            }
+            word[length++] = input[pos++] | 0x20;
+        }
+
+        const CommandWord* match = NULL;
+        for (size_t i = 0; i < sizeof(command_words) / sizeof(command_words[0]); i++) {
+            if (command_words[i].length == length && memcmp(command_words[i].word, word, length) == 0) {
+                match = &command_words[i];
+                break;
+            }
+        }
+        if (match == NULL) {
+            command->error_offset = start;
+            return PARSE_UNKNOWN_COMMAND;
+        }
+        command->type = match->type;
+
+        // The rest of a two-word command, separated by whitespace and matched without regard to case
+        if (match->second_word != NULL) {
+            int separator = pos;
+            while (is_space(input[pos])) pos++;
+            int second_start = pos;
+            const char* expected = match->second_word;
+            while (*expected != '\0' && is_letter(input[pos]) && (input[pos] | 0x20) == *expected) {
+                pos++;
+                expected++;
+            }
+            if (pos == separator || *expected != '\0' || is_letter(input[pos])) {
+                command->error_offset = second_start;
+                return PARSE_UNKNOWN_COMMAND;
+            }
+        }
+
+        // An optional game ID
+        if (match->takes_game_id) {
+            int separator = pos;
+            while (is_space(input[pos])) pos++;
+            if (input[pos] != '\0') {
+                if (pos == separator) {
+                    command->error_offset = pos;
+                    return PARSE_TRAILING_INPUT;
+                }
+                if ((error = read_number(input, &pos, &command->game_id)) != PARSE_OK) {
+                    command->error_offset = pos;
+                    return error;
+                }
+            }
+        }
+    } else {
+        command->error_offset = pos;
+        return PARSE_UNKNOWN_COMMAND;
+    }
+
+    while (is_space(input[pos])) pos++;
+    if (input[pos] != '\0') {
+        command->error_offset = pos;
+        return PARSE_TRAILING_INPUT;
+    }
+    return PARSE_OK;
+}
+
+// Describe a parse error for a player.
+const char* parse_error_message(ParseError error) {
+    switch (error) {
+        case PARSE_OK:
+            return "ok";
+        case PARSE_EMPTY:
+            return "no command entered";
+        case PARSE_UNKNOWN_COMMAND:
+            return "unknown command";
+        case PARSE_EXPECTED_NUMBER:
+            return "expected a number";
+        case PARSE_NUMBER_TOO_LARGE:
+            return "number is too large";
+        case PARSE_MISSING_COLUMN:
+            return "missing the column";
+        case PARSE_TRAILING_INPUT:
+            return "unexpected text after the command";
+    }
+    return "invalid input";
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * The commands a player can send.
+ */
+typedef enum {
+    COMMAND_MOVE,      // "<row> <col>": place a mark (1-based)
+    COMMAND_QUIT,      // "quit": leave the game
+    COMMAND_HINT,      // "hint" or "evaluate": ask for the best move
+    COMMAND_SPECTATE,  // "spectate [game id]": watch a game
+    COMMAND_STATS,     // "stats": show player statistics
+    COMMAND_RESUME,    // "resume [game id]": continue a saved game
+    COMMAND_REMATCH,   // "rematch": after a game, play the same opponent again
+    COMMAND_PLAY_AGAIN // "play again": after a game, find a new opponent
+} CommandType;
+
+/**
+ * Why a command could not be parsed.
+ */
+typedef enum {
+    PARSE_OK,
+    PARSE_EMPTY,             // The input was empty or only whitespace
+    PARSE_UNKNOWN_COMMAND,   // A word that is not a command
+    PARSE_EXPECTED_NUMBER,   // Something other than a digit where a number belongs
+    PARSE_NUMBER_TOO_LARGE,  // A number with more than COMMAND_MAX_DIGITS digits
+    PARSE_MISSING_COLUMN,    // A row with no column after it
+    PARSE_TRAILING_INPUT     // Extra text after a complete command
+} ParseError;
+
+// Numbers longer than this are rejected rather than risking overflow
+#define COMMAND_MAX_DIGITS 6
+
+// The prompts the server sends when players return to the lobby after a game, after a
+// finished game and after one a player left. Clients compare against these to know
+// their next line answers the lobby.
+#define LOBBY_PROMPT_REMATCH \
+    "Type 'rematch' to play the same opponent again, 'play again' to find a new opponent, or 'quit' to leave:"
+#define LOBBY_PROMPT "Type 'play again' to find a new opponent, or 'quit' to leave:"
+
+/**
+ * A parsed command.
+ * - type: Which command it is
+ * - row, col: The move for COMMAND_MOVE, exactly as typed (not range-checked)
+ * - game_id: The optional game ID for COMMAND_SPECTATE and COMMAND_RESUME, or 0
+ * - error_offset: For a failed parse, the index of the character that caused it
+ */
+typedef struct {
+    CommandType type;
+    int row;
+    int col;
+    int game_id;
+    int error_offset;
+} Command;
+
+/**
+ * Parse a line of player input in a single pass, without any formatted-input
+ * library calls. Leading and trailing whitespace is ignored, command words are
+ * matched without regard to case, and anything after a complete command is an
+ * error.
+ *
+ * \param input A null-terminated line of input
+ * \param command Filled in with the parsed command, or with error_offset on failure
+ * \return PARSE_OK, or the reason the input is not a command
+ */
+ParseError parse_command(const char* input, Command* command);
+
+/**
+ * Describe a parse error for a player.
+ *
+ * \param error The error returned by parse_command
+ * \return A short, static description (e.g., "expected a number")
+ */
+const char* parse_error_message(ParseError error);
@@ -0,0 +1,252 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "command.h"
+#include "message.h"
+
+// Inputs are capped so each run stays fast; longer inputs add no new frame shapes
+#define MAX_FUZZ_INPUT 8192
+
+// Stop the run with a message if an invariant does not hold
+#define FUZZ_CHECK(condition, message)                              \
+    do {                                                            \
+        if (!(condition)) {                                         \
+            fprintf(stderr, "Fuzz check failed: %s\n", (message));  \
+            abort();                                                \
+        }                                                           \
+    } while (0)
+
+/**
+ * Arguments for the thread that feeds bytes into the frame decoder.
+ * - fd: The socket to write to
+ * - data, size: The bytes to write
+ * - chunk: How many bytes to write at a time, so the reader sees short reads
+ */
+typedef struct {
+    int fd;
+    const uint8_t* data;
+    size_t size;
+    size_t chunk;
+} FeederArgs;
+
+// Write the input in small pieces, then close the socket so the reader sees EOF
+static void* run_feeder(void* arg) {
+    FeederArgs* args = arg;
+    size_t written = 0;
+    while (written < args->size) {
+        size_t len = args->size - written;
+        if (len > args->chunk) len = args->chunk;
+        ssize_t rc = write(args->fd, args->data + written, len);
+        if (rc <= 0) break;
+        written += rc;
+    }
+    close(args->fd);
+    return NULL;
+}
+
+/**
+ * Feed arbitrary bytes to receive_message in small pieces and compare every
+ * message it returns with a straightforward decoding of the same bytes. This
+ * covers short reads of both the header and the body, oversized lengths, and
+ * streams that end partway through a frame.
+ */
+static void fuzz_frame_decoder(const uint8_t* data, size_t size) {
+    if (size == 0) return;
+    size_t chunk = data[0] % 16 + 1;
+    data++;
+    size--;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) return;
+
+    FeederArgs args = {.fd = fds[1], .data = data, .size = size, .chunk = chunk};
+    pthread_t feeder;
+    if (pthread_create(&feeder, NULL, run_feeder, &args) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+
+    size_t offset = 0;
+    while (1) {
+        char* message = receive_message(fds[0]);
+
+        // Decode the next frame directly from the input
+        size_t len = 0;
+        int complete = 0;
+        if (size - offset >= sizeof(size_t)) {
+            memcpy(&len, data + offset, sizeof(size_t));
+            complete = len <= MAX_MESSAGE_LENGTH && size - offset - sizeof(size_t) >= len;
+        }
+
+        if (!complete) {
+            FUZZ_CHECK(message == NULL, "decoded a message from an incomplete or oversized frame");
+            break;
+        }
+        FUZZ_CHECK(message != NULL, "failed to decode a complete frame");
+        FUZZ_CHECK(memcmp(message, data + offset + sizeof(size_t), len) == 0, "decoded message differs from input");
+        FUZZ_CHECK(message[len] == '\0', "decoded message is not null-terminated");
+        free(message);
+        offset += sizeof(size_t) + len;
+    }
+
+    // Unblock the feeder if the decoder stopped before reading everything
+    shutdown(fds[0], SHUT_RDWR);
+    pthread_join(feeder, NULL);
+    close(fds[0]);
+}
+
+// Send the input as a message and check that it arrives unchanged
+static void fuzz_round_trip(const uint8_t* data, size_t size) {
+    char message[MAX_MESSAGE_LENGTH + 1];
+    if (size > MAX_MESSAGE_LENGTH) size = MAX_MESSAGE_LENGTH;
+    memcpy(message, data, size);
+    message[size] = '\0';
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) return;
+
+    FUZZ_CHECK(send_message(fds[0], message) == 0, "send_message failed");
+    char* received = receive_message(fds[1]);
+    FUZZ_CHECK(received != NULL, "receive_message failed");
+    FUZZ_CHECK(strcmp(received, message) == 0, "message changed in transit");
+    free(received);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * Run the command parser on the input as a string. Every move it accepts must
+ * also be accepted, with the same values, by the sscanf parsing it replaced.
+ */
+static void fuzz_command_parser(const uint8_t* data, size_t size) {
+    char input[MAX_MESSAGE_LENGTH + 1];
+    if (size > MAX_MESSAGE_LENGTH) size = MAX_MESSAGE_LENGTH;
+    memcpy(input, data, size);
+    input[size] = '\0';
+
+    Command command;
+    ParseError error = parse_command(input, &command);
+    if (error != PARSE_OK) {
+        FUZZ_CHECK(command.error_offset >= 0 && (size_t)command.error_offset <= strlen(input),
+                   "error offset is outside the input");
+        return;
+    }
+
+    if (command.type == COMMAND_MOVE) {
+        int row, col;
+        FUZZ_CHECK(sscanf(input, "%d %d", &row, &col) == 2, "accepted a move sscanf rejects");
+        FUZZ_CHECK(row == command.row && col == command.col, "parsed a different move than sscanf");
+    }
+}
+
+/**
+ * libFuzzer setup hook. The feeder thread may write after the decoder has given
+ * up on a stream, which must fail with EPIPE instead of killing the process.
+ */
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    signal(SIGPIPE, SIG_IGN);
+    return 0;
+}
+
+/**
+ * libFuzzer entry point. The first byte of the input picks what to fuzz and
+ * the rest is passed along.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0 || size > MAX_FUZZ_INPUT) return 0;
+
+    switch (data[0] % 3) {
+        case 0:
+            fuzz_frame_decoder(data + 1, size - 1);
+            break;
+        case 1:
+            fuzz_round_trip(data + 1, size - 1);
+            break;
+        case 2:
+            fuzz_command_parser(data + 1, size - 1);
+            break;
+    }
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+/*
+ * A driver for compilers without libFuzzer. Given file names it runs each file
+ * once, which is how crashes found by libFuzzer are reproduced. Otherwise it
+ * runs generated inputs: streams of well-formed frames with occasional
+ * corruption, and short strings built from the characters commands are made of.
+ */
+
+#define STANDALONE_RUNS 100000
+
+// Run one file as a fuzz input
+static int run_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    static uint8_t data[MAX_FUZZ_INPUT];
+    size_t size = fread(data, 1, sizeof(data), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(data, size);
+    return 0;
+}
+
+// Build a random input for one of the fuzz targets
+static size_t generate_input(uint8_t* data, unsigned int* seed) {
+    size_t size = 0;
+    data[size++] = rand_r(seed) % 3;
+
+    if (data[0] == 0) {
+        data[size++] = rand_r(seed);  // Chunk size
+        int frames = rand_r(seed) % 4;
+        for (int i = 0; i < frames; i++) {
+            size_t len = rand_r(seed) % 64;
+            if (rand_r(seed) % 8 == 0) len = MAX_MESSAGE_LENGTH + rand_r(seed) % 4;
+            if (rand_r(seed) % 16 == 0) len = (size_t)rand_r(seed) << 32;
+            if (size + sizeof(size_t) + len > MAX_FUZZ_INPUT) break;
+            memcpy(data + size, &len, sizeof(size_t));
+            size += sizeof(size_t);
+            for (size_t j = 0; j < len; j++) data[size++] = rand_r(seed);
+        }
+        // Sometimes cut the stream off partway through
+        if (size > 2 && rand_r(seed) % 4 == 0) size -= rand_r(seed) % (size - 2);
+        return size;
+    }
+
+    static const char alphabet[] = "0123456789 \t-+xquithnevalQUIT";
+    int len = rand_r(seed) % 12;
+    for (int i = 0; i < len; i++) data[size++] = alphabet[rand_r(seed) % (sizeof(alphabet) - 1)];
+    return size;
+}
+
+int main(int argc, char** argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            if (run_file(argv[i])) return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    static uint8_t data[MAX_FUZZ_INPUT];
+    unsigned int seed = 1;
+    for (int run = 0; run < STANDALONE_RUNS; run++) {
+        size_t size = generate_input(data, &seed);
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    printf("Ran %d generated inputs\n", STANDALONE_RUNS);
+    return EXIT_SUCCESS;
+}
+#endif
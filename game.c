@@ -0,0 +1,84 @@
+#include "game.h"
+
+#include <string.h>
+
+// Reset a game session for a new game between two players.
+void game_init(GameSession* game, int game_id, int player_x_fd, const char* player_x_name,
+               int player_o_fd, const char* player_o_name) {
+    game->game_id = game_id;
+    game->player_x_fd = player_x_fd;
+    game->player_o_fd = player_o_fd;
+    strncpy(game->player_x_name, player_x_name, 50);
+    strncpy(game->player_o_name, player_o_name, 50);
+    game->current_turn = 0; // X always starts first
+
+    // Initialize the board to empty spaces
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            game->board[i][j] = ' ';
+        }
+    }
+}
+
+// Place the current player's mark and decide whether the game is over.
+MoveResult game_play_move(GameSession* game, int row, int col) {
+    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) return MOVE_OUT_OF_RANGE;
+
+    // Check if the chosen spot is empty
+    if (game->board[row][col] != ' ') return MOVE_TAKEN;
+
+    // Place the 'X' or 'O' on the board
+    game->board[row][col] = (game->current_turn == 0) ? 'X' : 'O';
+
+    if (check_winner(game->board)) return MOVE_WIN;
+
+    // A full board with no winner is a draw
+    if (board_is_full(game->board)) return MOVE_DRAW;
+
+    return MOVE_OK;
+}
+
+// Check if the current board state has a winner.
+int check_winner(char board[BOARD_SIZE][BOARD_SIZE]) {
+    // Check rows and columns
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        // Check row i
+        if (board[i][0] != ' ') {
+            int j = 1;
+            while (j < BOARD_SIZE && board[i][j] == board[i][0]) j++;
+            if (j == BOARD_SIZE) return board[i][0];
+        }
+        // Check column i
+        if (board[0][i] != ' ') {
+            int j = 1;
+            while (j < BOARD_SIZE && board[j][i] == board[0][i]) j++;
+            if (j == BOARD_SIZE) return board[0][i];
+        }
+    }
+
+    // Check the main diagonal
+    if (board[0][0] != ' ') {
+        int j = 1;
+        while (j < BOARD_SIZE && board[j][j] == board[0][0]) j++;
+        if (j == BOARD_SIZE) return board[0][0];
+    }
+
+    // Check the anti-diagonal
+    if (board[0][BOARD_SIZE - 1] != ' ') {
+        int j = 1;
+        while (j < BOARD_SIZE && board[j][BOARD_SIZE - 1 - j] == board[0][BOARD_SIZE - 1]) j++;
+        if (j == BOARD_SIZE) return board[0][BOARD_SIZE - 1];
+    }
+
+    return 0; // No winner found
+}
+
+// Check if every cell on the board has been filled.
+int board_is_full(char board[BOARD_SIZE][BOARD_SIZE]) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            if (board[i][j] == ' ') return 0;
+        }
+    }
+    return 1;
+}
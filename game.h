@@ -0,0 +1,75 @@
+#pragma once
+
+#define BOARD_SIZE 3
+
+/**
+ * A structure representing a single game session of Tic-Tac-Toe.
+ * Each session tracks:
+ * - A unique game ID
+ * - Two player file descriptors (-1 for simulated players)
+ * - Both player names (Player X and Player O)
+ * - A 3x3 board array
+ * - The current turn indicator (0 for X, 1 for O)
+ */
+typedef struct {
+    int game_id;
+    int player_x_fd;
+    int player_o_fd;
+    char player_x_name[50];
+    char player_o_name[50];
+    char board[BOARD_SIZE][BOARD_SIZE];
+    int current_turn; // 0 for X, 1 for O
+} GameSession;
+
+/**
+ * The outcome of placing a mark with game_play_move.
+ */
+typedef enum {
+    MOVE_OK,           // The mark was placed and the game goes on
+    MOVE_WIN,          // The mark was placed and completed a line
+    MOVE_DRAW,         // The mark was placed and filled the board without a winner
+    MOVE_OUT_OF_RANGE, // The row or column is not on the board
+    MOVE_TAKEN         // The cell already has a mark in it
+} MoveResult;
+
+/**
+ * Reset a game session for a new game between two players: X moves first on an
+ * empty board.
+ *
+ * \param game The game session to initialize
+ * \param game_id A unique ID for the game
+ * \param player_x_fd File descriptor for Player X
+ * \param player_x_name Name of Player X
+ * \param player_o_fd File descriptor for Player O
+ * \param player_o_name Name of Player O
+ */
+void game_init(GameSession* game, int game_id, int player_x_fd, const char* player_x_name,
+               int player_o_fd, const char* player_o_name);
+
+/**
+ * Place the current player's mark and decide whether the game is over. The turn
+ * is not switched; the caller does that once it has handled the move.
+ *
+ * \param game The current game session
+ * \param row The row of the move (0-based)
+ * \param col The column of the move (0-based)
+ * \return The outcome of the move. The board is unchanged for MOVE_OUT_OF_RANGE and MOVE_TAKEN.
+ */
+MoveResult game_play_move(GameSession* game, int row, int col);
+
+/**
+ * Check if the current board state has a winner. A player wins by filling an
+ * entire row, column, or diagonal with their mark.
+ *
+ * \param board The current game board
+ * \return 'X' if X has won, 'O' if O has won, or 0 if no winner yet
+ */
+int check_winner(char board[BOARD_SIZE][BOARD_SIZE]);
+
+/**
+ * Check if every cell on the board has been filled.
+ *
+ * \param board The current game board
+ * \return Non-zero if there are no empty spaces left, 0 otherwise
+ */
+int board_is_full(char board[BOARD_SIZE][BOARD_SIZE]);
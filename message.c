@@ -5,8 +5,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+// Read exactly len bytes from a socket, looping over short reads. Returns 0 on success, or -1 if
+// the read fails or the connection closes first.
+static int read_all(int fd, void* buffer, size_t len) {
+  size_t bytes_read = 0;
+  while (bytes_read < len) {
+    // Try to read the entire remaining buffer
+    ssize_t rc = read(fd, (char*)buffer + bytes_read, len - bytes_read);
+
+    // Did the read fail? If so, return an error
+    if (rc <= 0) return -1;
+
+    // Update the number of bytes read
+    bytes_read += rc;
+  }
+  return 0;
+}
+
 // Send a across a socket with a header that includes the message length.
 int send_message(int fd, char* message) {
   // If the message is NULL, set errno to EINVAL and return an error
@@ -15,24 +33,35 @@ int send_message(int fd, char* message) {
     return -1;
   }
 
-  // First, send the length of the message in a size_t
+  // Send the length of the message in a size_t, followed by the message. Both go out in a single
+  // writev: writing the header on its own lets Nagle's algorithm hold back the message on TCP
+  // until the header is acknowledged, which adds a delayed-ACK timeout to every message.
   size_t len = strlen(message);
-  if (write(fd, &len, sizeof(size_t)) != sizeof(size_t)) {
-    // Writing failed, so return an error
-    return -1;
-  }
+  struct iovec parts[2] = {
+      {.iov_base = &len, .iov_len = sizeof(size_t)},
+      {.iov_base = message, .iov_len = len},
+  };
 
-  // Now we can send the message. Loop until the entire message has been written.
-  size_t bytes_written = 0;
-  while (bytes_written < len) {
-    // Try to write the entire remaining message
-    ssize_t rc = write(fd, message + bytes_written, len - bytes_written);
+  // Loop until the entire header and message have been written
+  struct iovec* remaining = parts;
+  int count = 2;
+  while (count > 0) {
+    // Try to write everything that is left
+    ssize_t rc = writev(fd, remaining, count);
 
     // Did the write fail? If so, return an error
     if (rc <= 0) return -1;
 
-    // If there was no error, write returned the number of bytes written
-    bytes_written += rc;
+    // If there was no error, writev returned the number of bytes written. Skip past them.
+    while (count > 0 && (size_t)rc >= remaining->iov_len) {
+      rc -= remaining->iov_len;
+      remaining++;
+      count--;
+    }
+    if (count > 0) {
+      remaining->iov_base = (char*)remaining->iov_base + rc;
+      remaining->iov_len -= rc;
+    }
   }
 
   return 0;
@@ -40,9 +69,9 @@ int send_message(int fd, char* message) {
 
 // Receive a message from a socket and return the message string (which must be freed later)
 char* receive_message(int fd) {
-  // First try to read in the message length
+  // First try to read in the message length. The header may arrive in pieces.
   size_t len;
-  if (read(fd, &len, sizeof(size_t)) != sizeof(size_t)) {
+  if (read_all(fd, &len, sizeof(size_t))) {
     // Reading failed. Return an error
     return NULL;
   }
@@ -55,21 +84,12 @@ char* receive_message(int fd) {
 
   // Allocate space for the message and a null terminator
   char* result = malloc(len + 1);
+  if (result == NULL) return NULL;
 
   // Try to read the message. Loop until the entire message has been read.
-  size_t bytes_read = 0;
-  while (bytes_read < len) {
-    // Try to read the entire remaining message
-    ssize_t rc = read(fd, result + bytes_read, len - bytes_read);
-
-    // Did the read fail? If so, return an error
-    if (rc <= 0) {
-      free(result);
-      return NULL;
-    }
-
-    // Update the number of bytes read
-    bytes_read += rc;
+  if (read_all(fd, result, len)) {
+    free(result);
+    return NULL;
   }
 
   // Add a null terminator to the message
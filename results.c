@@ -0,0 +1,239 @@
+#include "results.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Build the path of a results file. The file sink's context is the directory
+ * its files go in, or NULL for the current directory.
+ *
+ * \param dir The directory for results files, or NULL
+ * \param name The file's name
+ * \param path Set to the file's path
+ * \param size The size of the path buffer
+ */
+static void result_path(const char* dir, const char* name, char* path, size_t size) {
+    if (dir == NULL) {
+        snprintf(path, size, "%s", name);
+    } else {
+        snprintf(path, size, "%s/%s", dir, name);
+    }
+}
+
+/**
+ * Append a line of text to a given file.
+ *
+ * \param filename The file to append to
+ * \param content The line of content to write
+ */
+static void append_to_file(const char* filename, const char* content) {
+    FILE* f = fopen(filename, "a");
+    if (f) {
+        fprintf(f, "%s\n", content);
+        fclose(f);
+    }
+}
+
+/**
+ * Save the current incomplete game state (e.g., if a player quits or disconnects)
+ * to a file named "saved_games.txt".
+ *
+ * This function records:
+ * - The game ID
+ * - Both player names
+ * - Whose turn it was
+ * - The reason for incompleteness (status)
+ * - The final board state in a tic-tac-toe format
+ *
+ * \param dir The directory for results files, or NULL for the current directory
+ * \param game The game session to save
+ * \param status A string describing why the game ended incompletely (e.g., player quit)
+ */
+static void save_game_state(const char* dir, GameSession* game, const char* status) {
+    char filename[512];
+    result_path(dir, "saved_games.txt", filename, sizeof(filename));
+    FILE* f = fopen(filename, "a");
+    if (f) {
+        fprintf(f, "Game ID: %d\n", game->game_id);
+        fprintf(f, "Player X: %s\n", game->player_x_name);
+        fprintf(f, "Player O: %s\n", game->player_o_name);
+        fprintf(f, "Current Turn: %d\n", game->current_turn);
+        fprintf(f, "Status: %s\n", status);
+        fprintf(f, "Final Board State:\n");
+        // Print board in a tic-tac-toe style format
+        fprintf(f, " %c | %c | %c\n", game->board[0][0], game->board[0][1], game->board[0][2]);
+        fprintf(f, "---|---|---\n");
+        fprintf(f, " %c | %c | %c\n", game->board[1][0], game->board[1][1], game->board[1][2]);
+        fprintf(f, "---|---|---\n");
+        fprintf(f, " %c | %c | %c\n", game->board[2][0], game->board[2][1], game->board[2][2]);
+        fprintf(f, "\n------------------------\n");
+        fclose(f);
+    }
+}
+
+/**
+ * Update player statistics after a game concludes (win, lose, or draw).
+ *
+ * Records game results to "player_stats.txt":
+ * - Game ID
+ * - If it's a draw, record both player names
+ * - Otherwise, record the winner and loser
+ *
+ * \param dir The directory for results files, or NULL for the current directory
+ * \param game_id The ID of the completed game
+ * \param player_x_name Name of Player X
+ * \param player_o_name Name of Player O
+ * \param winner Name of the winner if applicable, or "" if a draw
+ * \param draw Non-zero if the game is a draw, 0 otherwise
+ */
+static void update_player_stats(const char* dir, int game_id, const char* player_x_name, const char* player_o_name, const char* winner, int draw) {
+    char filename[512];
+    result_path(dir, "player_stats.txt", filename, sizeof(filename));
+    FILE* f = fopen(filename, "a");
+    if (f) {
+        if (draw) {
+            fprintf(f, "Game #%d: Draw between %s and %s\n", game_id, player_x_name, player_o_name);
+        } else {
+            fprintf(f, "Game #%d: Winner: %s | Loser: %s\n", game_id, winner,
+                    (strcmp(winner, player_x_name) == 0) ? player_o_name : player_x_name);
+        }
+        fclose(f);
+    }
+}
+
+/**
+ * Initialize a log file for a new game. Logs the game ID, player names,
+ * and that the game has started. Each game has its own log "game_log_<id>.txt".
+ *
+ * \param dir The directory for results files, or NULL for the current directory
+ * \param game The game session to log
+ */
+static void log_game_init(const char* dir, GameSession* game) {
+    char name[64], filename[512];
+    snprintf(name, sizeof(name), "game_log_%d.txt", game->game_id);
+    result_path(dir, name, filename, sizeof(filename));
+    FILE* f = fopen(filename, "w");
+    if (f) {
+        fprintf(f, "Game ID: %d\n", game->game_id);
+        fprintf(f, "Player X: %s\n", game->player_x_name);
+        fprintf(f, "Player O: %s\n", game->player_o_name);
+        fprintf(f, "Game Start\n");
+        fclose(f);
+    }
+}
+
+/**
+ * Log a single move to the game's log file.
+ *
+ *
+ * \param dir The directory for results files, or NULL for the current directory
+ * \param game The current game session
+ * \param player_name The name of the player who made the move
+ * \param row The row of the move (0-based internally, will add 1 for logging)
+ * \param col The column of the move (0-based internally, will add 1 for logging)
+ */
+static void log_move(const char* dir, GameSession* game, const char* player_name, int row, int col) {
+    char name[64], filename[512];
+    snprintf(name, sizeof(name), "game_log_%d.txt", game->game_id);
+    result_path(dir, name, filename, sizeof(filename));
+    FILE* f = fopen(filename, "a");
+    if (f) {
+        fprintf(f, "%s moved to (%d, %d)\n", player_name, row+1, col+1);
+        fprintf(f, "Current Board:\n");
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            fprintf(f, " %c | %c | %c\n",
+                    game->board[i][0], game->board[i][1], game->board[i][2]);
+            if (i < BOARD_SIZE - 1) fprintf(f, "---|---|---\n");
+        }
+        fprintf(f, "\n");
+        fclose(f);
+    }
+}
+
+/**
+ * Log the final result of the game into the "game_log_<id>.txt" file.
+ *
+ * \param dir The directory for results files, or NULL for the current directory
+ * \param game The game session that ended
+ * \param result A string describing the game's result (winner/loser or draw)
+ */
+static void log_game_result(const char* dir, GameSession* game, const char* result) {
+    char name[64], filename[512];
+    snprintf(name, sizeof(name), "game_log_%d.txt", game->game_id);
+    result_path(dir, name, filename, sizeof(filename));
+    append_to_file(filename, result);
+}
+
+/**
+ * Record the end of a game: the result goes in the game's log, incomplete games
+ * are saved, and finished games update the player stats.
+ *
+ * \param game The game session that ended
+ * \param result How the game ended
+ * \param player_name The winner, or the player who quit or disconnected
+ */
+static void file_game_finished(void* ctx, GameSession* game, GameResult result, const char* player_name) {
+    const char* dir = ctx;
+    char status_str[100];
+    switch (result) {
+        case RESULT_WIN: {
+            const char* loser_name = (strcmp(player_name, game->player_x_name) == 0) ? game->player_o_name : game->player_x_name;
+            char result_line[200];
+            snprintf(result_line, sizeof(result_line), "Result: %s (winner) vs %s (loser)", player_name, loser_name);
+            log_game_result(dir, game, result_line);
+            // Update player stats with a win/loss result
+            update_player_stats(dir, game->game_id, game->player_x_name, game->player_o_name, player_name, 0);
+            break;
+        }
+        case RESULT_DRAW:
+            log_game_result(dir, game, "Result: Draw");
+            // Record the draw in player stats
+            update_player_stats(dir, game->game_id, game->player_x_name, game->player_o_name, "", 1);
+            break;
+        case RESULT_QUIT:
+            snprintf(status_str, sizeof(status_str), "Incomplete - Player %s Quit", player_name);
+            save_game_state(dir, game, status_str);
+            log_game_result(dir, game, "Result: Player Quit / Incomplete");
+            break;
+        case RESULT_DISCONNECT:
+            snprintf(status_str, sizeof(status_str), "Incomplete - Player %s Disconnected", player_name);
+            save_game_state(dir, game, status_str);
+            log_game_result(dir, game, "Result: Incomplete (Disconnection)");
+            break;
+    }
+}
+
+static void file_game_started(void* ctx, GameSession* game) {
+    log_game_init(ctx, game);
+}
+
+static void file_move_made(void* ctx, GameSession* game, const char* player_name, int row, int col) {
+    log_move(ctx, game, player_name, row, col);
+}
+
+const ResultSink file_result_sink = {
+    .game_started = file_game_started,
+    .move_made = file_move_made,
+    .game_finished = file_game_finished,
+    .ctx = NULL,
+};
+
+// Make a file sink that writes its files in dir.
+ResultSink file_result_sink_in(const char* dir) {
+    ResultSink sink = file_result_sink;
+    sink.ctx = (void*)dir;
+    return sink;
+}
+
+static void null_game_started(void* ctx, GameSession* game) {}
+
+static void null_move_made(void* ctx, GameSession* game, const char* player_name, int row, int col) {}
+
+static void null_game_finished(void* ctx, GameSession* game, GameResult result, const char* player_name) {}
+
+const ResultSink null_result_sink = {
+    .game_started = null_game_started,
+    .move_made = null_move_made,
+    .game_finished = null_game_finished,
+    .ctx = NULL,
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "game.h"
+
+/**
+ * How a game ended, as reported to a result sink.
+ */
+typedef enum {
+    RESULT_WIN,        // A player completed a line
+    RESULT_DRAW,       // The board filled up without a winner
+    RESULT_QUIT,       // A player quit before the game was decided
+    RESULT_DISCONNECT  // A player disconnected before the game was decided
+} GameResult;
+
+/**
+ * A destination for game results. Live games and simulated games report their
+ * progress through the same three callbacks, so anything that records results
+ * (game logs, saved games, player stats) only has to be written once.
+ * - game_started: A new game has been set up
+ * - move_made: player_name placed a mark at (row, col), 0-based
+ * - game_finished: The game ended. player_name is the winner for RESULT_WIN, the
+ *   player who left for RESULT_QUIT and RESULT_DISCONNECT, and unused for RESULT_DRAW
+ * - ctx: Passed as the first argument to every callback
+ */
+typedef struct {
+    void (*game_started)(void* ctx, GameSession* game);
+    void (*move_made)(void* ctx, GameSession* game, const char* player_name, int row, int col);
+    void (*game_finished)(void* ctx, GameSession* game, GameResult result, const char* player_name);
+    void* ctx;
+} ResultSink;
+
+// Records results to files the way the live server always has: a game_log_<id>.txt
+// per game, incomplete games in saved_games.txt, and outcomes in player_stats.txt.
+extern const ResultSink file_result_sink;
+
+/**
+ * Make a file sink that writes the same files as file_result_sink, but in the
+ * directory dir instead of the current one, so its game logs and stats stay
+ * apart from the live server's.
+ *
+ * \param dir The directory to write results files in. It must already exist
+ *            and outlive the sink.
+ * \return The file sink
+ */
+ResultSink file_result_sink_in(const char* dir);
+
+// Discards all results.
+extern const ResultSink null_result_sink;
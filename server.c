@@ -3,203 +3,123 @@
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <poll.h>
+#include <signal.h>
 
+#include "command.h"
+#include "game.h"
 #include "message.h"
+#include "results.h"
+#include "simulate.h"
 #include "socket.h"
+#include "solver.h"
 
 #define MAX_PLAYERS 100
-#define BOARD_SIZE 3
-
-/**
- * A structure representing a single game session of Tic-Tac-Toe.
- * Each session tracks:
- * - A unique game ID
- * - Two player file descriptors
- * - Both player names (Player X and Player O)
- * - A 3x3 board array
- * - The current turn indicator (0 for X, 1 for O)
- */
-typedef struct {
-    int game_id;
-    int player_x_fd;
-    int player_o_fd;
-    char player_x_name[50];
-    char player_o_name[50];
-    char board[BOARD_SIZE][BOARD_SIZE];
-    int current_turn; // 0 for X, 1 for O
-} GameSession;
 
 // Global counters for clients and games
 static int client_count = 0;
 static int game_count = 0;
 static pthread_mutex_t game_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-/**
- * Append a line of text to a given file.
- *
- * \param filename The file to append to
- * \param content The line of content to write
- */
-static void append_to_file(const char* filename, const char* content) {
-    FILE* f = fopen(filename, "a");
-    if (f) {
-        fprintf(f, "%s\n", content);
-        fclose(f);
-    }
-}
+// Sessions from finished games, kept for reuse instead of being freed (guarded by game_mutex)
+static GameSession* session_pool[MAX_PLAYERS];
+static int pooled_sessions = 0;
 
 /**
- * Save the current incomplete game state (e.g., if a player quits or disconnects)
- * to a file named "saved_games.txt".
- *
- * This function records:
- * - The game ID
- * - Both player names
- * - Whose turn it was
- * - The reason for incompleteness (status)
- * - The final board state in a tic-tac-toe format
- *
- * \param game The game session to save
- * \param status A string describing why the game ended incompletely (e.g., player quit)
+ * A player waiting for an opponent. Players coming from the lobby remember who
+ * they just played, so two players who did not both ask for a rematch are not
+ * paired straight back together.
  */
-static void save_game_state(GameSession* game, const char* status) {
-    FILE* f = fopen("saved_games.txt", "a");
-    if (f) {
-        fprintf(f, "Game ID: %d\n", game->game_id);
-        fprintf(f, "Player X: %s\n", game->player_x_name);
-        fprintf(f, "Player O: %s\n", game->player_o_name);
-        fprintf(f, "Current Turn: %d\n", game->current_turn);
-        fprintf(f, "Status: %s\n", status);
-        fprintf(f, "Final Board State:\n");
-        // Print board in a tic-tac-toe style format
-        fprintf(f, " %c | %c | %c\n", game->board[0][0], game->board[0][1], game->board[0][2]);
-        fprintf(f, "---|---|---\n");
-        fprintf(f, " %c | %c | %c\n", game->board[1][0], game->board[1][1], game->board[1][2]);
-        fprintf(f, "---|---|---\n");
-        fprintf(f, " %c | %c | %c\n", game->board[2][0], game->board[2][1], game->board[2][2]);
-        fprintf(f, "\n------------------------\n");
-        fclose(f);
-    }
-}
+typedef struct {
+    int fd;
+    char name[50];
+    int last_opponent_fd;  // The opponent they just left, or -1 for a new player
+} WaitingPlayer;
 
-/**
- * Update player statistics after a game concludes (win, lose, or draw).
- *
- * Records game results to "player_stats.txt":
- * - Game ID
- * - If it's a draw, record both player names
- * - Otherwise, record the winner and loser
- *
- * \param game_id The ID of the completed game
- * \param player_x_name Name of Player X
- * \param player_o_name Name of Player O
- * \param winner Name of the winner if applicable, or "" if a draw
- * \param draw Non-zero if the game is a draw, 0 otherwise
- */
-static void update_player_stats(int game_id, const char* player_x_name, const char* player_o_name, const char* winner, int draw) {
-    FILE* f = fopen("player_stats.txt", "a");
-    if (f) {
-        if (draw) {
-            fprintf(f, "Game #%d: Draw between %s and %s\n", game_id, player_x_name, player_o_name);
-        } else {
-            fprintf(f, "Game #%d: Winner: %s | Loser: %s\n", game_id, winner,
-                    (strcmp(winner, player_x_name) == 0) ? player_o_name : player_x_name);
-        }
-        fclose(f);
-    }
-}
+// Players waiting for an opponent, longest waiting first (guarded by matchmaking_mutex)
+static WaitingPlayer waiting_players[MAX_PLAYERS];
+static int waiting_count = 0;
+static pthread_mutex_t matchmaking_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Unix domain socket path to remove when the server is stopped, or NULL
+static const char* unix_socket_path = NULL;
 
 /**
- * Initialize a log file for a new game. Logs the game ID, player names,
- * and that the game has started. Each game has its own log "game_log_<id>.txt".
- *
- * \param game The game session to log
+ * How a game ended, as far as the players' connections are concerned.
  */
-static void log_game_init(GameSession* game) {
-    char filename[64];
-    snprintf(filename, sizeof(filename), "game_log_%d.txt", game->game_id);
-    FILE* f = fopen(filename, "w");
-    if (f) {
-        fprintf(f, "Game ID: %d\n", game->game_id);
-        fprintf(f, "Player X: %s\n", game->player_x_name);
-        fprintf(f, "Player O: %s\n", game->player_o_name);
-        fprintf(f, "Game Start\n");
-        fclose(f);
-    }
-}
+typedef enum {
+    END_FINISHED, // Someone won or it was a draw; both players are still connected
+    END_X_LEFT,   // Player X quit or disconnected
+    END_O_LEFT    // Player O quit or disconnected
+} GameEnd;
 
 /**
- * Log a single move to the game's log file.
- *
+ * Take a game session from the pool of finished sessions, or allocate one if
+ * the pool is empty.
  *
- * \param game The current game session
- * \param player_name The name of the player who made the move
- * \param row The row of the move (0-based internally, will add 1 for logging)
- * \param col The column of the move (0-based internally, will add 1 for logging)
+ * \return A game session, not yet initialized
  */
-static void log_move(GameSession* game, const char* player_name, int row, int col) {
-    char filename[64];
-    snprintf(filename, sizeof(filename), "game_log_%d.txt", game->game_id);
-    FILE* f = fopen(filename, "a");
-    if (f) {
-        fprintf(f, "%s moved to (%d, %d)\n", player_name, row+1, col+1);
-        fprintf(f, "Current Board:\n");
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            fprintf(f, " %c | %c | %c\n",
-                    game->board[i][0], game->board[i][1], game->board[i][2]);
-            if (i < BOARD_SIZE - 1) fprintf(f, "---|---|---\n");
-        }
-        fprintf(f, "\n");
-        fclose(f);
-    }
+static GameSession* acquire_session(void) {
+    pthread_mutex_lock(&game_mutex);
+    GameSession* game = (pooled_sessions > 0) ? session_pool[--pooled_sessions] : NULL;
+    pthread_mutex_unlock(&game_mutex);
+
+    if (game == NULL) game = malloc(sizeof(GameSession));
+    return game;
 }
 
 /**
- * Log the final result of the game into the "game_log_<id>.txt" file.
+ * Return a game session to the pool once its players are gone, so the next game
+ * can reuse it. Sessions beyond the size of the pool are freed.
  *
- * \param game The game session that ended
- * \param result A string describing the game's result (winner/loser or draw)
+ * \param game The game session to give up
  */
-static void log_game_result(GameSession* game, const char* result) {
-    char filename[64];
-    snprintf(filename, sizeof(filename), "game_log_%d.txt", game->game_id);
-    append_to_file(filename, result);
+static void release_session(GameSession* game) {
+    pthread_mutex_lock(&game_mutex);
+    if (pooled_sessions < MAX_PLAYERS) {
+        session_pool[pooled_sessions++] = game;
+        game = NULL;
+    }
+    pthread_mutex_unlock(&game_mutex);
+    free(game);
 }
 
 /**
- * Create a new Tic-Tac-Toe game session. This sets up:
+ * Start a new game in a session. This sets up:
  * - A unique game ID
  * - Assigns players X and O, their FDs and names
  * - Initializes an empty board
  * - Logs the game start
  *
+ * \param game The session to start the game in
  * \param player_x_fd File descriptor for Player X
  * \param player_x_name Name of Player X
  * \param player_o_fd File descriptor for Player O
  * \param player_o_name Name of Player O
- * \return A pointer to the newly created GameSession structure
  */
-static GameSession* create_game(int player_x_fd, const char* player_x_name, int player_o_fd, const char* player_o_name) {
+static void start_game(GameSession* game, int player_x_fd, const char* player_x_name, int player_o_fd, const char* player_o_name) {
     pthread_mutex_lock(&game_mutex);
     int game_id = ++game_count; 
     pthread_mutex_unlock(&game_mutex);
 
-    GameSession* game = malloc(sizeof(GameSession));
-    game->game_id = game_id;
-    game->player_x_fd = player_x_fd;
-    game->player_o_fd = player_o_fd;
-    strncpy(game->player_x_name, player_x_name, 50);
-    strncpy(game->player_o_name, player_o_name, 50);
-    game->current_turn = 0; // X always starts first
-
-    // Initialize the 3x3 board to empty spaces
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            game->board[i][j] = ' ';
-        }
-    }
+    game_init(game, game_id, player_x_fd, player_x_name, player_o_fd, player_o_name);
 
-    log_game_init(game);
+    file_result_sink.game_started(file_result_sink.ctx, game);
+}
+
+/**
+ * Create a new Tic-Tac-Toe game session, reusing a pooled session if there is
+ * one, and start a game in it.
+ *
+ * \param player_x_fd File descriptor for Player X
+ * \param player_x_name Name of Player X
+ * \param player_o_fd File descriptor for Player O
+ * \param player_o_name Name of Player O
+ * \return A pointer to the GameSession structure
+ */
+static GameSession* create_game(int player_x_fd, const char* player_x_name, int player_o_fd, const char* player_o_name) {
+    GameSession* game = acquire_session();
+    start_game(game, player_x_fd, player_x_name, player_o_fd, player_o_name);
     return game;
 }
 
@@ -218,34 +138,6 @@ static void log_board(GameSession* game) {
     printf("\n");
 }
 
-/**
- * Check if the current board state has a winner.
- *
- * Returns 'X' if X has won, 'O' if O has won, or 0 if no winner yet.
- *
- * \param board The current 3x3 game board
- * \return 'X', 'O', or 0 depending on the game state
- */
-static int check_winner(char board[BOARD_SIZE][BOARD_SIZE]) {
-    // Check rows and columns
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        // Check row i
-        if (board[i][0] != ' ' && board[i][0] == board[i][1] && board[i][1] == board[i][2])
-            return board[i][0];
-        // Check column i
-        if (board[0][i] != ' ' && board[0][i] == board[1][i] && board[1][i] == board[2][i])
-            return board[0][i];
-    }
-
-    // Check diagonals
-    if (board[0][0] != ' ' && board[0][0] == board[1][1] && board[1][1] == board[2][2])
-        return board[0][0];
-    if (board[0][2] != ' ' && board[0][2] == board[1][1] && board[1][1] == board[2][0])
-        return board[0][2];
-
-    return 0; // No winner found
-}
-
 /**
  * Send the current board state to both players over the network in a tic-tac-toe format.
  *
@@ -263,91 +155,132 @@ static void send_board(GameSession* game) {
 }
 
 /**
- * Handle a single game session in a dedicated thread. This function:
+ * Send the best move and the value of the current position to the player whose
+ * turn it is, along with the shared evaluation cache's hit rate.
+ *
+ * \param game The current game session
+ * \param player_fd File descriptor of the player asking for the hint
+ */
+static void send_hint(GameSession* game, int player_fd) {
+    SolverResult result = solver_evaluate(game->board);
+
+    const char* value;
+    if (SOLVER_IS_WIN(result.score)) {
+        value = "With best play you can force a win";
+    } else if (SOLVER_IS_LOSS(result.score)) {
+        value = "With best play your opponent can force a win";
+    } else if (result.exact) {
+        value = "With best play the game is a draw";
+    } else if (result.score > 0) {
+        value = "The position looks better for you (estimate)";
+    } else if (result.score < 0) {
+        value = "The position looks better for your opponent (estimate)";
+    } else {
+        value = "The position looks even (estimate)";
+    }
+
+    unsigned long lookups, hits;
+    solver_cache_stats(&lookups, &hits);
+    double hit_rate = (lookups > 0) ? 100.0 * hits / lookups : 0.0;
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "Hint: play '%d %d'. %s. (Cache hit rate: %.1f%% of %lu lookups)",
+             result.row + 1, result.col + 1, value, hit_rate, lookups);
+    send_message(player_fd, buffer);
+}
+
+/**
+ * Play one game between the session's two players. This function:
  * - Coordinates turns between players
  * - Reads moves from the current player
+ * - Answers hint requests with the best move for the current player
  * - Updates the board and logs moves
  * - Checks for win or draw conditions
  * - Handles quitting or disconnection by players
- * - Ends the session when the game concludes
  *
- * \param arg A pointer to the GameSession for this game
- * \return NULL when the thread finishes
+ * \param game The game session to play
+ * \return How the game ended
  */
-static void* handle_game(void* arg) {
-    GameSession* game = (GameSession*)arg;
+static GameEnd play_game(GameSession* game) {
     printf("[Game %d] Started: Player 1 (%s, X) vs Player 2 (%s, O)\n",
            game->game_id, game->player_x_name, game->player_o_name);
 
-    int winner = 0;
-
     // Keep running until we have a winner or a break condition (quit, disconnect, or draw)
-    while (!winner) {
+    while (1) {
         // Determine whose turn it is
         int current_player_fd = (game->current_turn == 0) ? game->player_x_fd : game->player_o_fd;
         int other_player_fd = (game->current_turn == 0) ? game->player_o_fd : game->player_x_fd;
         const char* current_player_name = (game->current_turn == 0) ? game->player_x_name : game->player_o_name;
         const char* other_player_name = (game->current_turn == 0) ? game->player_o_name : game->player_x_name;
 
-        send_message(current_player_fd, "Your turn. Enter row and column (e.g., '1 2') or type 'quit' to exit:");
+        send_message(current_player_fd, "Your turn. Enter row and column (e.g., '1 2'), 'hint' for a suggestion, or type 'quit' to exit:");
         char* move = receive_message(current_player_fd);
 
         if (!move) {
             // The current player disconnected abruptly
             printf("[Game %d] %s disconnected.\n", game->game_id, current_player_name);
-            char status_str[100];
-            snprintf(status_str, sizeof(status_str), "Incomplete - Player %s Disconnected", current_player_name);
-            save_game_state(game, status_str);
-            log_game_result(game, "Result: Incomplete (Disconnection)");
+            file_result_sink.game_finished(file_result_sink.ctx, game, RESULT_DISCONNECT, current_player_name);
             send_message(other_player_fd, "Your opponent disconnected. You win by default! Game is Over.");
-            break;
+            return (game->current_turn == 0) ? END_X_LEFT : END_O_LEFT;
+        }
+
+        // Parse the player's command
+        Command command;
+        ParseError error = parse_command(move, &command);
+        free(move);
+
+        if (error != PARSE_OK) {
+            // Invalid input format
+            char buffer[128];
+            snprintf(buffer, sizeof(buffer), "Invalid move (%s at character %d). Try again.",
+                     parse_error_message(error), command.error_offset + 1);
+            send_message(current_player_fd, buffer);
+            continue;
         }
 
-        if (strcmp(move, "quit") == 0) {
+        if (command.type == COMMAND_QUIT) {
             // Current player chose to quit the game
             printf("[Game %d] %s quit the game.\n", game->game_id, current_player_name);
-            char status_str[100];
-            snprintf(status_str, sizeof(status_str), "Incomplete - Player %s Quit", current_player_name);
-            save_game_state(game, status_str);
-            log_game_result(game, "Result: Player Quit / Incomplete");
+            file_result_sink.game_finished(file_result_sink.ctx, game, RESULT_QUIT, current_player_name);
             send_message(current_player_fd, "You quit the game. Game is Over.");
             send_message(other_player_fd, "Your opponent quit. You win! Game is Over.");
-            free(move);
-            break;
+            return (game->current_turn == 0) ? END_X_LEFT : END_O_LEFT;
         }
 
-        int row, col;
-        // Parse the move as two integers
-        if (sscanf(move, "%d %d", &row, &col) != 2 || row < 1 || row > BOARD_SIZE || col < 1 || col > BOARD_SIZE) {
-            // Invalid input format or out-of-range move
-            send_message(current_player_fd, "Invalid move. Try again.");
-            free(move);
+        if (command.type == COMMAND_HINT) {
+            // Current player asked for the best move; their turn continues afterward
+            send_hint(game, current_player_fd);
+            printf("[Game %d] %s asked for a hint.\n", game->game_id, current_player_name);
             continue;
         }
 
-        int row_index = row - 1;
-        int col_index = col - 1;
-
-        // Check if the chosen spot is empty
-        if (game->board[row_index][col_index] != ' ') {
-            send_message(current_player_fd, "That spot is already taken. Try again.");
-            free(move);
+        if (command.type != COMMAND_MOVE) {
+            send_message(current_player_fd, "That command is not available during a game. Try again.");
             continue;
         }
 
+        int row = command.row;
+        int col = command.col;
+
         // Place the 'X' or 'O' on the board
-        game->board[row_index][col_index] = (game->current_turn == 0) ? 'X' : 'O';
+        MoveResult result = game_play_move(game, row - 1, col - 1);
+        if (result == MOVE_OUT_OF_RANGE) {
+            send_message(current_player_fd, "Invalid move. Try again.");
+            continue;
+        }
+        if (result == MOVE_TAKEN) {
+            send_message(current_player_fd, "That spot is already taken. Try again.");
+            continue;
+        }
         printf("[Game %d] %s made a move at (%d, %d)\n", game->game_id, current_player_name, row, col);
 
         // Log the move and update the internal structures
-        log_move(game, current_player_name, row_index, col_index);
-        free(move);
+        file_result_sink.move_made(file_result_sink.ctx, game, current_player_name, row - 1, col - 1);
 
         log_board(game);
 
         // Check if we have a winner
-        winner = check_winner(game->board);
-        if (winner) {
+        if (result == MOVE_WIN) {
             // Announce winner
             char buffer[100];
             snprintf(buffer, sizeof(buffer), "Congratulations %s! You win! Game is Over.", current_player_name);
@@ -355,36 +288,20 @@ static void* handle_game(void* arg) {
             snprintf(buffer, sizeof(buffer), "Sorry %s, you lost. Better luck next time! Game is Over.", other_player_name);
             send_message(other_player_fd, buffer);
 
-            char result_line[200];
-            snprintf(result_line, sizeof(result_line), "Result: %s (winner) vs %s (loser)",
-                     current_player_name, other_player_name);
-            log_game_result(game, result_line);
-
-            // Update player stats with a win/loss result
-            update_player_stats(game->game_id, game->player_x_name, game->player_o_name, current_player_name, 0);
+            // Log the result and update player stats with a win/loss result
+            file_result_sink.game_finished(file_result_sink.ctx, game, RESULT_WIN, current_player_name);
             printf("[Game %d] Game is Over: %s won against %s.\n", game->game_id, current_player_name, other_player_name);
-            break;
+            return END_FINISHED;
         }
 
         // Check for a draw (no empty spaces left and no winner)
-        int draw = 1;
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                if (game->board[i][j] == ' ') {
-                    draw = 0;
-                    break;
-                }
-            }
-            if (!draw) break;
-        }
-        if (draw) {
+        if (result == MOVE_DRAW) {
             send_message(game->player_x_fd, "The game is a draw! Game is Over.");
             send_message(game->player_o_fd, "The game is a draw! Game is Over.");
-            log_game_result(game, "Result: Draw");
-            // Record the draw in player stats
-            update_player_stats(game->game_id, game->player_x_name, game->player_o_name, "", 1);
+            // Log the result and record the draw in player stats
+            file_result_sink.game_finished(file_result_sink.ctx, game, RESULT_DRAW, "");
             printf("[Game %d] Game is Over: The game ended in a draw.\n", game->game_id);
-            break;
+            return END_FINISHED;
         }
 
         // Switch turns for the next iteration
@@ -393,23 +310,260 @@ static void* handle_game(void* arg) {
         // Send the updated board to both players
         send_board(game);
     }
+}
 
-    // Clean up the game session
-    close(game->player_x_fd);
-    close(game->player_o_fd);
-    free(game);
+static void* handle_game(void* arg);
+
+/**
+ * Pair a player with the longest waiting player, other than the opponent they
+ * just left, or have them wait for an opponent if there is none. A paired game
+ * runs in its own thread.
+ *
+ * \param player_fd File descriptor for the player
+ * \param player_name Name of the player
+ * \param last_opponent_fd The opponent the player just left in the lobby, or -1
+ */
+static void matchmake(int player_fd, const char* player_name, int last_opponent_fd) {
+    pthread_mutex_lock(&matchmaking_mutex);
+
+    // Find someone to play, skipping the two players who just turned each other down
+    int match = -1;
+    for (int i = 0; i < waiting_count; i++) {
+        if (waiting_players[i].fd != last_opponent_fd || waiting_players[i].last_opponent_fd != player_fd) {
+            match = i;
+            break;
+        }
+    }
+
+    // If no one is available, this player waits for an opponent
+    if (match == -1) {
+        if (waiting_count == MAX_PLAYERS) {
+            pthread_mutex_unlock(&matchmaking_mutex);
+            send_message(player_fd, "The server is full. Please try again later.");
+            close(player_fd);
+            return;
+        }
+        WaitingPlayer* waiting = &waiting_players[waiting_count++];
+        waiting->fd = player_fd;
+        strncpy(waiting->name, player_name, 50);
+        waiting->last_opponent_fd = last_opponent_fd;
+        pthread_mutex_unlock(&matchmaking_mutex);
+        send_message(player_fd, "Waiting for an opponent...");
+        return;
+    }
+
+    // Another player was waiting, so we can start a game
+    int opponent_fd = waiting_players[match].fd;
+    char opponent_name[50];
+    strncpy(opponent_name, waiting_players[match].name, 50);
+    waiting_count--;
+    memmove(&waiting_players[match], &waiting_players[match + 1], (waiting_count - match) * sizeof(WaitingPlayer));
+    pthread_mutex_unlock(&matchmaking_mutex);
+
+    GameSession* game = create_game(opponent_fd, opponent_name, player_fd, player_name);
+
+    // Create a thread to handle the game session
+    pthread_t game_thread;
+    if (pthread_create(&game_thread, NULL, handle_game, game) != 0) {
+        perror("Failed to create game thread");
+        close(opponent_fd);
+        close(player_fd);
+        release_session(game);
+        return;
+    }
+    pthread_detach(game_thread);
+}
+
+// Where a player stands in the lobby after a game
+typedef enum {
+    LOBBY_DECIDING,  // Has not answered the lobby prompt yet
+    LOBBY_REMATCH,   // Wants a rematch and is waiting on the opponent
+    LOBBY_DONE       // Has left, or has been sent off to find a new opponent
+} LobbyState;
+
+/**
+ * Settle a player who will not be getting a rematch: send them to find a new
+ * opponent, or say goodbye and close their connection.
+ *
+ * \param player_fd File descriptor for the player
+ * \param player_name Name of the player
+ * \param opponent_fd File descriptor for the opponent they just played
+ * \param play_again Non-zero to find a new opponent, 0 to disconnect
+ */
+static void leave_lobby(int player_fd, const char* player_name, int opponent_fd, int play_again) {
+    if (play_again) {
+        printf("[Lobby] %s is looking for a new opponent.\n", player_name);
+        matchmake(player_fd, player_name, opponent_fd);
+    } else {
+        printf("[Lobby] %s left.\n", player_name);
+        send_message(player_fd, "Goodbye!");
+        close(player_fd);
+    }
+}
+
+/**
+ * Return both players to the lobby after a game. Each player still connected is
+ * asked whether they want a rematch, a new opponent, or to leave, and both are
+ * listened to at once so neither waits on the other unless they asked for a
+ * rematch. A player waiting on a rematch is still listened to, so they can
+ * change their mind or disconnect while they wait. Players who will not get a
+ * rematch are settled immediately.
+ *
+ * \param game The game session that just ended
+ * \param end How the game ended
+ * \return Non-zero if both players asked for a rematch, 0 otherwise
+ */
+static int run_lobby(GameSession* game, GameEnd end) {
+    int fds[2] = {game->player_x_fd, game->player_o_fd};
+    const char* names[2] = {game->player_x_name, game->player_o_name};
+    LobbyState states[2] = {LOBBY_DECIDING, LOBBY_DECIDING};
+
+    // A player who quit or disconnected is already gone
+    if (end != END_FINISHED) {
+        int gone = (end == END_X_LEFT) ? 0 : 1;
+        close(fds[gone]);
+        states[gone] = LOBBY_DONE;
+    }
+
+    char* prompt = (end == END_FINISHED) ? LOBBY_PROMPT_REMATCH : LOBBY_PROMPT;
+    for (int i = 0; i < 2; i++) {
+        if (states[i] == LOBBY_DECIDING) send_message(fds[i], prompt);
+    }
+
+    while (states[0] == LOBBY_DECIDING || states[1] == LOBBY_DECIDING) {
+        // Wait for whichever player still in the lobby answers first
+        struct pollfd pending[2];
+        int players[2];
+        int count = 0;
+        for (int i = 0; i < 2; i++) {
+            if (states[i] != LOBBY_DONE) {
+                pending[count] = (struct pollfd){.fd = fds[i], .events = POLLIN};
+                players[count++] = i;
+            }
+        }
+        if (poll(pending, count, -1) == -1) continue;
+
+        for (int k = 0; k < count; k++) {
+            if (!(pending[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            int i = players[k];
+            int other = 1 - i;
+
+            // Settling the other player may have already sent this one off
+            if (states[i] == LOBBY_DONE) continue;
+
+            char* reply = receive_message(fds[i]);
+            int disconnected = (reply == NULL);
+            Command command;
+            if (disconnected) {
+                // The player disconnected
+                command.type = COMMAND_QUIT;
+            } else if (parse_command(reply, &command) != PARSE_OK ||
+                       (command.type != COMMAND_REMATCH && command.type != COMMAND_PLAY_AGAIN &&
+                        command.type != COMMAND_QUIT)) {
+                free(reply);
+                send_message(fds[i], "Invalid choice. Try again.");
+                send_message(fds[i], prompt);
+                continue;
+            }
+            free(reply);
+
+            if (command.type == COMMAND_REMATCH && states[other] != LOBBY_DONE) {
+                states[i] = LOBBY_REMATCH;
+                if (states[other] == LOBBY_DECIDING) {
+                    send_message(fds[i], "Waiting for your opponent to decide... (type 'play again' or 'quit' to stop waiting)");
+                }
+                continue;
+            }
+
+            // No rematch is possible any more, so this player is settled now
+            if (command.type == COMMAND_REMATCH) {
+                send_message(fds[i], "Your opponent is not available for a rematch.");
+            }
+            leave_lobby(fds[i], names[i], fds[other], command.type == COMMAND_PLAY_AGAIN || command.type == COMMAND_REMATCH);
+            states[i] = LOBBY_DONE;
+
+            // An opponent waiting on a rematch will not be getting one
+            if (states[other] == LOBBY_REMATCH) {
+                send_message(fds[other], "Your opponent is not available for a rematch.");
+                leave_lobby(fds[other], names[other], fds[i], 1);
+                states[other] = LOBBY_DONE;
+            }
+        }
+    }
+
+    return states[0] == LOBBY_REMATCH && states[1] == LOBBY_REMATCH;
+}
+
+/**
+ * Handle a game session in a dedicated thread. The same two players keep
+ * playing in this session, on their existing connections, for as long as they
+ * both ask for rematches, taking turns going first. After that, each player is
+ * either sent to find a new opponent or disconnected, and the session goes back
+ * to the pool.
+ *
+ * \param arg A pointer to the GameSession for this game
+ * \return NULL when the thread finishes
+ */
+static void* handle_game(void* arg) {
+    GameSession* game = (GameSession*)arg;
+
+    while (1) {
+        GameEnd end = play_game(game);
+        if (!run_lobby(game, end)) break;
+
+        // Start a rematch in the same session with the players' roles swapped
+        int player_x_fd = game->player_o_fd;
+        int player_o_fd = game->player_x_fd;
+        char player_x_name[50], player_o_name[50];
+        strncpy(player_x_name, game->player_o_name, 50);
+        strncpy(player_o_name, game->player_x_name, 50);
+        start_game(game, player_x_fd, player_x_name, player_o_fd, player_o_name);
+        printf("[Game %d] Rematch between %s and %s.\n", game->game_id, player_x_name, player_o_name);
+    }
+
+    // Put the session back for a later game
+    release_session(game);
     return NULL;
 }
 
+/**
+ * Remove the Unix domain socket file and exit when the server is stopped with
+ * Ctrl-C or kill, so the next server can bind the same path.
+ *
+ * \param signum The signal that stopped the server
+ */
+static void handle_stop_signal(int signum) {
+    if (unix_socket_path != NULL) unlink(unix_socket_path);
+    _exit(128 + signum);
+}
+
 /**
  * The main function sets up the server:
+ * - With "--simulate", runs in-process simulated games instead (see simulate.h)
  * - Opens a server socket on an available port
- * - Listens for incoming player connections
+ * - With "--unix <path>", also opens a Unix domain socket for local players
+ * - Listens for incoming player connections on both
  * - As players connect, pairs them into games
  * - If one player is waiting, the next player to connect starts a game
- * - Each game runs in its own thread
+ * - Each game runs in its own thread, and players return to a lobby afterward
  */
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--simulate") == 0) {
+        return simulate_main(argc - 1, argv + 1);
+    }
+
+    // A player can disconnect while we are writing to them; that should fail the write, not end the server
+    signal(SIGPIPE, SIG_IGN);
+
+    // "--unix <path>" also accepts local players on a Unix domain socket
+    const char* unix_path = NULL;
+    if (argc == 3 && strcmp(argv[1], "--unix") == 0) {
+        unix_path = argv[2];
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--unix <socket path>]\n       %s --simulate [options]\n", argv[0], argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
     unsigned short port = 0;
     int server_socket_fd = server_socket_open(&port);
     if (server_socket_fd == -1) {
@@ -425,12 +579,41 @@ int main() {
 
     printf("Tic-Tac-Toe Server listening on port %u\n", port);
 
-    int waiting_player_fd = -1;
-    char waiting_player_name[50];
+    // Listen on the Unix domain socket as well, if one was requested
+    struct pollfd listeners[2] = {{.fd = server_socket_fd, .events = POLLIN}};
+    int listener_count = 1;
+    if (unix_path != NULL) {
+        int unix_socket_fd = unix_socket_open(unix_path);
+        if (unix_socket_fd == -1 || listen(unix_socket_fd, 5)) {
+            perror("Failed to listen on Unix domain socket");
+            exit(EXIT_FAILURE);
+        }
+        listeners[listener_count++] = (struct pollfd){.fd = unix_socket_fd, .events = POLLIN};
+        printf("Tic-Tac-Toe Server listening on %s\n", unix_path);
+
+        // Remove the socket file when the server is stopped
+        unix_socket_path = unix_path;
+        signal(SIGINT, handle_stop_signal);
+        signal(SIGTERM, handle_stop_signal);
+    }
 
-    // Main loop: accept players and pair them for games
+    // Main loop: accept players from either socket and pair them for games
     while (1) {
-        int client_socket_fd = server_socket_accept(server_socket_fd);
+        if (poll(listeners, listener_count, -1) == -1) {
+            perror("Failed to wait for client connections");
+            continue;
+        }
+
+        // Take the connection from whichever socket is ready
+        int ready_fd = server_socket_fd;
+        for (int i = 0; i < listener_count; i++) {
+            if (listeners[i].revents & POLLIN) {
+                ready_fd = listeners[i].fd;
+                break;
+            }
+        }
+
+        int client_socket_fd = server_socket_accept(ready_fd);
         if (client_socket_fd == -1) {
             perror("Failed to accept client connection");
             continue;
@@ -451,29 +634,11 @@ int main() {
 
         printf("[Client %d] Player %d connected as %s\n", client_id, client_id, player_name);
 
-        // If no one is waiting, this player waits for an opponent
-        if (waiting_player_fd == -1) {
-            waiting_player_fd = client_socket_fd;
-            strncpy(waiting_player_name, player_name, 50);
-            send_message(client_socket_fd, "Waiting for an opponent...");
-            free(player_name);
-        } else {
-            // Another player was waiting, so we can start a game
-            GameSession* game = create_game(waiting_player_fd, waiting_player_name, client_socket_fd, player_name);
-            free(player_name);
-
-            // Create a thread to handle the game session
-            pthread_t game_thread;
-            if (pthread_create(&game_thread, NULL, handle_game, game) != 0) {
-                perror("Failed to create game thread");
-                free(game);
-            }
-            pthread_detach(game_thread);
-
-            waiting_player_fd = -1; // Reset waiting player
-        }
+        // Pair the player with a waiting opponent, or have them wait for one
+        matchmake(client_socket_fd, player_name, -1);
+        free(player_name);
     }
 
-    close(server_socket_fd);
+    for (int i = 0; i < listener_count; i++) close(listeners[i].fd);
     return 0;
 }
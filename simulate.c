@@ -0,0 +1,390 @@
+#include "simulate.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "results.h"
+#include "solver.h"
+
+#define CELL_COUNT (BOARD_SIZE * BOARD_SIZE)
+#define LINE_COUNT (2 * BOARD_SIZE + 2)
+
+// Only print the first few mismatches; the summary has the total
+#define MAX_REPORTED_MISMATCHES 10
+
+// Where "--sink file" writes its files, kept apart from the live server's game logs and stats
+#define DEFAULT_SINK_DIR "simulated_games"
+
+typedef enum { BOT_RANDOM, BOT_SOLVER } BotKind;
+
+/**
+ * Settings shared by every worker thread.
+ */
+typedef struct {
+    unsigned long games;
+    int threads;
+    BotKind bot;
+    const ResultSink* sink;
+    unsigned long long seed;
+} SimConfig;
+
+/**
+ * The state of one worker thread. Each worker plays its share of the games and
+ * keeps its own tallies so threads never contend on shared counters.
+ */
+typedef struct {
+    const SimConfig* config;
+    unsigned long games;
+    uint64_t rng;
+
+    // What the result sink was told about the current game
+    int moves[CELL_COUNT];
+    int move_count;
+    int finished_count;
+    GameResult result;
+    char winner_mark;
+
+    // Totals across all of this worker's games
+    unsigned long x_wins;
+    unsigned long o_wins;
+    unsigned long draws;
+    unsigned long mismatches;
+} SimWorker;
+
+// One bitmask per row, column, and diagonal, with bit (row * BOARD_SIZE + col) per cell
+static uint64_t line_masks[LINE_COUNT];
+
+static atomic_int next_game_id;
+static atomic_int reported_mismatches;
+
+// Build the masks used by the reference checker
+static void init_line_masks(void) {
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int k = 0; k < BOARD_SIZE; k++) {
+            line_masks[i] |= 1ull << (i * BOARD_SIZE + k);               // Row i
+            line_masks[BOARD_SIZE + i] |= 1ull << (k * BOARD_SIZE + i);  // Column i
+        }
+        line_masks[2 * BOARD_SIZE] |= 1ull << (i * BOARD_SIZE + i);
+        line_masks[2 * BOARD_SIZE + 1] |= 1ull << (i * BOARD_SIZE + BOARD_SIZE - 1 - i);
+    }
+}
+
+/**
+ * Replay a sequence of moves with bitboards, independently of check_winner and
+ * game_play_move, to work out how the game should have ended.
+ *
+ * \param moves Cells in the order they were played (row * BOARD_SIZE + col)
+ * \param move_count Number of moves played
+ * \param winner_mark Set to 'X' or 'O' for a win, or 0
+ * \param end_move Set to the number of moves after which the game was decided
+ * \return 1 if the game was decided, 0 if it should still be in progress
+ */
+static int reference_outcome(const int* moves, int move_count, char* winner_mark, int* end_move) {
+    uint64_t marks[2] = {0, 0};
+    for (int i = 0; i < move_count; i++) {
+        uint64_t* mine = &marks[i % 2];
+        *mine |= 1ull << moves[i];
+        for (int line = 0; line < LINE_COUNT; line++) {
+            if ((*mine & line_masks[line]) == line_masks[line]) {
+                *winner_mark = (i % 2 == 0) ? 'X' : 'O';
+                *end_move = i + 1;
+                return 1;
+            }
+        }
+        if (i + 1 == CELL_COUNT) {
+            *winner_mark = 0;
+            *end_move = i + 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// xorshift64*: fast, and good enough to pick cells
+static uint64_t next_random(SimWorker* worker) {
+    worker->rng ^= worker->rng >> 12;
+    worker->rng ^= worker->rng << 25;
+    worker->rng ^= worker->rng >> 27;
+    return worker->rng * 0x2545F4914F6CDD1Dull;
+}
+
+// Pick a move for the player whose turn it is
+static void choose_move(SimWorker* worker, GameSession* game, int* row, int* col) {
+    if (worker->config->bot == BOT_SOLVER && game->current_turn == 0) {
+        SolverResult result = solver_evaluate(game->board);
+        *row = result.row;
+        *col = result.col;
+        return;
+    }
+
+    int empty[CELL_COUNT];
+    int count = 0;
+    for (int cell = 0; cell < CELL_COUNT; cell++) {
+        if (game->board[cell / BOARD_SIZE][cell % BOARD_SIZE] == ' ') empty[count++] = cell;
+    }
+    int cell = empty[next_random(worker) % count];
+    *row = cell / BOARD_SIZE;
+    *col = cell % BOARD_SIZE;
+}
+
+/*
+ * The simulation reports results through a recording sink: it remembers what it
+ * was told about the current game for the reference check, then forwards each
+ * call to the configured sink.
+ */
+
+static void recording_game_started(void* ctx, GameSession* game) {
+    SimWorker* worker = ctx;
+    worker->move_count = 0;
+    worker->finished_count = 0;
+    worker->config->sink->game_started(worker->config->sink->ctx, game);
+}
+
+static void recording_move_made(void* ctx, GameSession* game, const char* player_name, int row, int col) {
+    SimWorker* worker = ctx;
+    if (worker->move_count < CELL_COUNT) worker->moves[worker->move_count++] = row * BOARD_SIZE + col;
+    worker->config->sink->move_made(worker->config->sink->ctx, game, player_name, row, col);
+}
+
+static void recording_game_finished(void* ctx, GameSession* game, GameResult result, const char* player_name) {
+    SimWorker* worker = ctx;
+    worker->finished_count++;
+    worker->result = result;
+    worker->winner_mark = 0;
+    if (result == RESULT_WIN) {
+        worker->winner_mark = (strcmp(player_name, game->player_x_name) == 0) ? 'X' : 'O';
+    }
+    worker->config->sink->game_finished(worker->config->sink->ctx, game, result, player_name);
+}
+
+/**
+ * Compare what the result sink was told about a finished game with the outcome
+ * computed by the reference checker.
+ *
+ * \return 1 if they agree, 0 otherwise
+ */
+static int check_game(SimWorker* worker, GameSession* game) {
+    char expected_mark;
+    int end_move;
+    int decided = reference_outcome(worker->moves, worker->move_count, &expected_mark, &end_move);
+
+    const char* problem = NULL;
+    if (worker->finished_count != 1) {
+        problem = "game did not finish exactly once";
+    } else if (!decided) {
+        problem = "game finished before it was decided";
+    } else if (end_move != worker->move_count) {
+        problem = "game continued after it was decided";
+    } else if (expected_mark == 0 && worker->result != RESULT_DRAW) {
+        problem = "expected a draw";
+    } else if (expected_mark != 0 && (worker->result != RESULT_WIN || worker->winner_mark != expected_mark)) {
+        problem = "expected a different winner";
+    }
+
+    if (problem == NULL) return 1;
+
+    if (atomic_fetch_add(&reported_mismatches, 1) < MAX_REPORTED_MISMATCHES) {
+        fprintf(stderr, "[Game %d] Mismatch: %s (%d moves:", game->game_id, problem, worker->move_count);
+        for (int i = 0; i < worker->move_count; i++) {
+            fprintf(stderr, " %d,%d", worker->moves[i] / BOARD_SIZE + 1, worker->moves[i] % BOARD_SIZE + 1);
+        }
+        fprintf(stderr, ")\n");
+    }
+    return 0;
+}
+
+/**
+ * Play one complete game between two bots, the same way handle_game plays a
+ * live one: place marks with game_play_move and report through the result sink.
+ */
+static void play_game(SimWorker* worker, const ResultSink* sink) {
+    GameSession game;
+    game_init(&game, atomic_fetch_add(&next_game_id, 1) + 1, -1, "Bot X", -1, "Bot O");
+    sink->game_started(sink->ctx, &game);
+
+    while (1) {
+        const char* current_player_name = (game.current_turn == 0) ? game.player_x_name : game.player_o_name;
+
+        int row, col;
+        choose_move(worker, &game, &row, &col);
+        MoveResult result = game_play_move(&game, row, col);
+
+        // Bots only choose empty cells, so a rejected move means the rules are wrong
+        if (result == MOVE_OUT_OF_RANGE || result == MOVE_TAKEN) break;
+
+        sink->move_made(sink->ctx, &game, current_player_name, row, col);
+
+        if (result == MOVE_WIN) {
+            sink->game_finished(sink->ctx, &game, RESULT_WIN, current_player_name);
+            break;
+        }
+        if (result == MOVE_DRAW) {
+            sink->game_finished(sink->ctx, &game, RESULT_DRAW, "");
+            break;
+        }
+
+        // Switch turns for the next iteration
+        game.current_turn = 1 - game.current_turn;
+    }
+
+    if (!check_game(worker, &game)) {
+        worker->mismatches++;
+    } else if (worker->result == RESULT_DRAW) {
+        worker->draws++;
+    } else if (worker->winner_mark == 'X') {
+        worker->x_wins++;
+    } else {
+        worker->o_wins++;
+    }
+}
+
+// Thread entry point: play this worker's share of the games
+static void* run_worker(void* arg) {
+    SimWorker* worker = arg;
+    ResultSink sink = {
+        .game_started = recording_game_started,
+        .move_made = recording_move_made,
+        .game_finished = recording_game_finished,
+        .ctx = worker,
+    };
+
+    for (unsigned long i = 0; i < worker->games; i++) {
+        play_game(worker, &sink);
+    }
+    return NULL;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s --simulate [--games N] [--threads N] [--bot random|solver] [--sink null|file[:DIR]] [--seed N]\n",
+            program);
+}
+
+// Run the server's game engine on simulated games.
+int simulate_main(int argc, char** argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    SimConfig config = {
+        .games = 1000000,
+        .threads = (cpus > 0) ? (int)cpus : 1,
+        .bot = BOT_RANDOM,
+        .sink = &null_result_sink,
+        .seed = 1,
+    };
+    ResultSink file_sink;
+    const char* sink_dir = NULL;
+
+    // Parse options, each of which takes a value
+    for (int i = 1; i < argc; i++) {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            print_usage("server");
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(argv[i], "--games") == 0) {
+            config.games = strtoul(value, NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            config.threads = atoi(value);
+        } else if (strcmp(argv[i], "--bot") == 0 && strcmp(value, "random") == 0) {
+            config.bot = BOT_RANDOM;
+        } else if (strcmp(argv[i], "--bot") == 0 && strcmp(value, "solver") == 0) {
+            config.bot = BOT_SOLVER;
+        } else if (strcmp(argv[i], "--sink") == 0 && strcmp(value, "null") == 0) {
+            config.sink = &null_result_sink;
+        } else if (strcmp(argv[i], "--sink") == 0 && strcmp(value, "file") == 0) {
+            sink_dir = DEFAULT_SINK_DIR;
+        } else if (strcmp(argv[i], "--sink") == 0 && strncmp(value, "file:", 5) == 0 && value[5] != '\0') {
+            sink_dir = value + 5;
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            config.seed = strtoull(value, NULL, 10);
+        } else {
+            print_usage("server");
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+    if (config.threads < 1) config.threads = 1;
+
+    // Simulated games are numbered from 1 like live ones, so their files go in a directory of their own
+    if (sink_dir != NULL) {
+        if (mkdir(sink_dir, 0755) == -1 && errno != EEXIST) {
+            perror("Failed to create simulation results directory");
+            return EXIT_FAILURE;
+        }
+        file_sink = file_result_sink_in(sink_dir);
+        config.sink = &file_sink;
+    }
+
+    init_line_masks();
+
+    SimWorker* workers = calloc(config.threads, sizeof(SimWorker));
+    pthread_t* threads = malloc(config.threads * sizeof(pthread_t));
+    if (workers == NULL || threads == NULL) {
+        perror("Failed to allocate simulation workers");
+        free(workers);
+        free(threads);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Split the games as evenly as possible and start the workers
+    int started = 0;
+    for (int i = 0; i < config.threads; i++) {
+        workers[i].config = &config;
+        workers[i].games = config.games / config.threads + ((unsigned long)i < config.games % config.threads);
+        // xorshift needs a non-zero state
+        workers[i].rng = (config.seed + 1) * 0x9E3779B97F4A7C15ull + (uint64_t)i * 0xBF58476D1CE4E5B9ull;
+        if (workers[i].rng == 0) workers[i].rng = 1;
+
+        if (pthread_create(&threads[i], NULL, run_worker, &workers[i]) != 0) {
+            perror("Failed to create simulation thread");
+            break;
+        }
+        started++;
+    }
+
+    SimWorker total = {0};
+    unsigned long games = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        games += workers[i].games;
+        total.x_wins += workers[i].x_wins;
+        total.o_wins += workers[i].o_wins;
+        total.draws += workers[i].draws;
+        total.mismatches += workers[i].mismatches;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("Simulated %lu games on %d threads in %.3f s (%.0f games/sec)\n",
+           games, started, seconds, (seconds > 0) ? games / seconds : 0.0);
+    printf("X wins: %lu | O wins: %lu | Draws: %lu\n", total.x_wins, total.o_wins, total.draws);
+    printf("Reference check: %lu mismatches\n", total.mismatches);
+
+    // The solver plays X perfectly, so on a board it can solve outright it must never lose
+    int solver_lost = (config.bot == BOT_SOLVER && SOLVER_MAX_DEPTH >= CELL_COUNT && total.o_wins > 0);
+    if (solver_lost) {
+        printf("Solver check: X lost %lu games it should not have\n", total.o_wins);
+    }
+
+    if (config.bot == BOT_SOLVER) {
+        unsigned long lookups, hits;
+        solver_cache_stats(&lookups, &hits);
+        printf("Solver cache: %lu lookups, %.1f%% hit rate\n", lookups, (lookups > 0) ? 100.0 * hits / lookups : 0.0);
+    }
+
+    free(workers);
+    free(threads);
+    return (total.mismatches == 0 && !solver_lost && started == config.threads) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
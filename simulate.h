@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * Run the server's game engine on simulated games, with no sockets involved.
+ * Bots play complete games through the same rule code (game_play_move) and
+ * result pipeline (ResultSink) as live games, spread across worker threads.
+ * Every finished game is replayed by an independent reference checker and its
+ * outcome compared with the one reported to the result sink.
+ *
+ * Options:
+ *   --games N      Number of games to play (default 1000000)
+ *   --threads N    Number of worker threads (default: one per online CPU)
+ *   --bot KIND     "random" for two random players (default), or "solver" for
+ *                  a solver-driven X against a random O
+ *   --sink KIND    "null" to discard results (default), or "file" to write the
+ *                  same logs, saved games, and stats files as the live server,
+ *                  in the directory "simulated_games". "file:DIR" writes them
+ *                  in DIR instead. Either directory is created if needed.
+ *   --seed N       Seed for the random players (default 1)
+ *
+ * \param argc Argument count, with argv[0] being "--simulate"
+ * \param argv Argument vector
+ * \return EXIT_SUCCESS if every game matched the reference checker, EXIT_FAILURE otherwise
+ */
+int simulate_main(int argc, char** argv);
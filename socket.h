@@ -3,54 +3,63 @@
 #include <errno.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 /**
  * Create a new socket and connect to a server.
  *
  * \param server_name   A null-terminated string that specifies either the IP
- *                      address or host name of the server to connect to.
+ *                      address (IPv4 or IPv6) or host name of the server to
+ *                      connect to.
  * \param port          The port number the server should be listening on.
  *
  * \returns   A file descriptor for the connected socket, or -1 if there is an
  *            error. The errno value will be set by the failed POSIX call.
  */
 static int socket_connect(char* server_name, unsigned short port) {
-  // Look up the server by name
-  struct hostent* server = gethostbyname(server_name);
-  if (server == NULL) {
-    // Set errno, since gethostbyname does not
+  // Look up the server by name. Unlike gethostbyname, getaddrinfo is
+  // thread-safe and returns IPv6 addresses as well as IPv4 ones.
+  char port_str[8];
+  snprintf(port_str, sizeof(port_str), "%u", port);
+  struct addrinfo hints = {
+      .ai_family = AF_UNSPEC,      // Either IPv4 or IPv6
+      .ai_socktype = SOCK_STREAM,  // TCP
+  };
+  struct addrinfo* addresses;
+  if (getaddrinfo(server_name, port_str, &hints, &addresses)) {
+    // Set errno, since getaddrinfo does not
     errno = EHOSTDOWN;
     return -1;
   }
 
-  // Open a socket
-  int fd = socket(AF_INET, SOCK_STREAM, 0);
-  if (fd == -1) {
-    return -1;
-  }
-
-  // Set up an address
-  struct sockaddr_in addr = {
-      .sin_family = AF_INET,   // This is an internet socket
-      .sin_port = htons(port)  // Connect to the appropriate port number
-  };
+  // Try each address in turn until one of them connects
+  int fd = -1;
+  for (struct addrinfo* addr = addresses; addr != NULL; addr = addr->ai_next) {
+    fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    if (fd == -1) continue;
 
-  // Copy the server address info returned by gethostbyname into the address
-  memcpy(&addr.sin_addr.s_addr, server->h_addr, server->h_length);
+    if (connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) break;
 
-  // Connect to the server
-  if (connect(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in))) {
+    // Keep the errno from the failed connect across close
+    int saved_errno = errno;
     close(fd);
-    return -1;
+    errno = saved_errno;
+    fd = -1;
   }
 
+  freeaddrinfo(addresses);
   return fd;
 }
 
 /**
- * Open a server socket that will accept TCP connections from any other machine.
+ * Open a server socket that will accept TCP connections from any other machine,
+ * over IPv6 and IPv4 where the system supports it, and IPv4 alone otherwise.
  *
  * \param port    A pointer to a port value. If *port is greater than zero, this
  *                function will attempt to open a server socket using that port.
@@ -63,27 +72,42 @@ static int socket_connect(char* server_name, unsigned short port) {
  *                errno will be set by the POSIX socket function that failed.
  */
 static int server_socket_open(unsigned short* port) {
-  // Create a server socket. Return if there is an error.
-  int fd = socket(AF_INET, SOCK_STREAM, 0);
-  if (fd == -1) {
-    return -1;
-  }
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  memset(&addr, 0, sizeof(addr));
 
-  // Set up the server socket to listen
-  struct sockaddr_in addr = {
-      .sin_family = AF_INET,          // This is an internet socket
-      .sin_addr.s_addr = INADDR_ANY,  // Listen for connections from any client
-      .sin_port = htons(*port)        // Use the specified port (may be zero)
-  };
+  // Create a server socket, preferring one that accepts both IPv6 and IPv4
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  if (fd != -1) {
+    int v6only = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+
+    struct sockaddr_in6* addr6 = (struct sockaddr_in6*)&addr;
+    addr6->sin6_family = AF_INET6;       // This is an internet socket
+    addr6->sin6_addr = in6addr_any;      // Listen for connections from any client
+    addr6->sin6_port = htons(*port);     // Use the specified port (may be zero)
+    addrlen = sizeof(struct sockaddr_in6);
+  } else {
+    // No IPv6 support, so fall back to IPv4. Return if there is an error.
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+      return -1;
+    }
+
+    struct sockaddr_in* addr4 = (struct sockaddr_in*)&addr;
+    addr4->sin_family = AF_INET;          // This is an internet socket
+    addr4->sin_addr.s_addr = INADDR_ANY;  // Listen for connections from any client
+    addr4->sin_port = htons(*port);       // Use the specified port (may be zero)
+    addrlen = sizeof(struct sockaddr_in);
+  }
 
   // Bind the server socket to the address. Return if there is an error.
-  if (bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in))) {
+  if (bind(fd, (struct sockaddr*)&addr, addrlen)) {
     close(fd);
     return -1;
   }
 
   // Get information about the new socket
-  socklen_t addrlen = sizeof(struct sockaddr_in);
   if (getsockname(fd, (struct sockaddr*)&addr, &addrlen)) {
     close(fd);
     return -1;
@@ -91,14 +115,19 @@ static int server_socket_open(unsigned short* port) {
 
   // Read out the port information for the socket. If *port was zero, the OS
   // will select a port for us. This tells the caller which port was chosen.
-  *port = ntohs(addr.sin_port);
+  if (addr.ss_family == AF_INET6) {
+    *port = ntohs(((struct sockaddr_in6*)&addr)->sin6_port);
+  } else {
+    *port = ntohs(((struct sockaddr_in*)&addr)->sin_port);
+  }
 
   // Return the server socket file descriptor
   return fd;
 }
 
 /**
- * Accept an incoming connection on a server socket.
+ * Accept an incoming connection on a server socket. This works for both TCP
+ * and Unix domain server sockets.
  *
  * \param server_socket_fd  The server socket that should accept the connection.
  *
@@ -107,8 +136,8 @@ static int server_socket_open(unsigned short* port) {
  */
 static int server_socket_accept(int server_socket_fd) {
   // Create a struct to record the connected client's address
-  struct sockaddr_in client_addr;
-  socklen_t client_addr_len = sizeof(struct sockaddr_in);
+  struct sockaddr_storage client_addr;
+  socklen_t client_addr_len = sizeof(struct sockaddr_storage);
 
   // Block until we receive a connection or failure
   int client_socket_fd = accept(server_socket_fd, (struct sockaddr*)&client_addr, &client_addr_len);
@@ -120,3 +149,116 @@ static int server_socket_accept(int server_socket_fd) {
 
   return client_socket_fd;
 }
+
+/**
+ * Fill in a Unix domain socket address for a path.
+ *
+ * \returns   0 on success, or -1 with errno set to ENAMETOOLONG if the path
+ *            does not fit in a socket address.
+ */
+static int unix_socket_address(const char* path, struct sockaddr_un* addr) {
+  memset(addr, 0, sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr->sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  strcpy(addr->sun_path, path);
+  return 0;
+}
+
+/**
+ * Open a server socket that will accept connections from processes on this
+ * machine through a Unix domain socket. Local connections skip the TCP stack,
+ * so they are cheaper than connecting to localhost over TCP.
+ *
+ * \param path    The file system path for the socket. A stale socket file left
+ *                at this path by a server that has exited is removed first. If
+ *                anything else is there, or another server is still listening
+ *                on it, this fails with errno set to EADDRINUSE.
+ *
+ * \returns       A file descriptor for the server socket. The socket has been
+ *                bound to the path, but is not listening. In case of failure,
+ *                this function returns -1. The value of errno will be set by
+ *                the POSIX socket function that failed.
+ */
+static int unix_socket_open(const char* path) {
+  struct sockaddr_un addr;
+  if (unix_socket_address(path, &addr)) {
+    return -1;
+  }
+
+  // Create a server socket. Return if there is an error.
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return -1;
+  }
+
+  // Remove a socket file left behind by an earlier server, then bind. Anything
+  // else at the path, including the socket of a server still running, is kept.
+  struct stat info;
+  if (lstat(path, &info) == 0) {
+    int stale = 0;
+    if (S_ISSOCK(info.st_mode)) {
+      int probe_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (probe_fd != -1) {
+        stale = connect(probe_fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_un)) == -1 && errno == ECONNREFUSED;
+        close(probe_fd);
+      }
+    }
+    if (!stale) {
+      close(fd);
+      errno = EADDRINUSE;
+      return -1;
+    }
+    unlink(path);
+  }
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_un))) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Create a new socket and connect to a server's Unix domain socket.
+ *
+ * \param path    The file system path the server is listening on.
+ *
+ * \returns   A file descriptor for the connected socket, or -1 if there is an
+ *            error. The errno value will be set by the failed POSIX call.
+ */
+static int unix_socket_connect(const char* path) {
+  struct sockaddr_un addr;
+  if (unix_socket_address(path, &addr)) {
+    return -1;
+  }
+
+  // Open a socket
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return -1;
+  }
+
+  // Connect to the server
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(struct sockaddr_un))) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Create a pair of connected sockets within this process, with no listening
+ * socket involved. The bench uses a pair to measure message framing without
+ * any network stack in the way.
+ *
+ * \param fds   Set to the two connected socket file descriptors.
+ *
+ * \returns   0 on success, or -1 with errno set by the failed socketpair call.
+ */
+static int socket_pair_open(int fds[2]) {
+  return socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+}
@@ -0,0 +1,233 @@
+#include "solver.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Each cell takes two bits of the position key, so boards up to 5x5 fit in 64 bits
+_Static_assert(BOARD_SIZE * BOARD_SIZE * 2 <= 64, "board too large for a 64-bit position key");
+
+#define CACHE_BITS 16
+#define CACHE_SLOTS (1u << CACHE_BITS)
+
+// Layout of a cache entry's data word
+#define ENTRY_VALID (1ull << 63)
+#define ENTRY_EXACT (1ull << 62)
+#define ENTRY_DEPTH_SHIFT 32
+#define ENTRY_SCORE_BIAS 0x8000
+
+/**
+ * A slot in the transposition cache. Slots are written without locks: the data
+ * word is stored alongside check = key ^ data. A reader that races with a writer
+ * may see a data word from one store and a check word from another, but then
+ * check ^ data will not reproduce the key and the read is treated as a miss.
+ */
+typedef struct {
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} CacheSlot;
+
+static CacheSlot cache[CACHE_SLOTS];
+static atomic_ulong cache_lookups;
+static atomic_ulong cache_hits;
+
+// Encode a cell as two bits: 0 for empty, 1 for X, 2 for O
+static uint64_t cell_code(char c) {
+    return (c == 'X') ? 1 : (c == 'O') ? 2 : 0;
+}
+
+/**
+ * Compute the key shared by a position and all of its rotations and reflections.
+ * The board is packed under each of the eight symmetries of the square and the
+ * smallest packing is used.
+ *
+ * \param board The board to hash
+ * \return The canonical position key
+ */
+static uint64_t canonical_key(char board[BOARD_SIZE][BOARD_SIZE]) {
+    const int n = BOARD_SIZE - 1;
+    uint64_t keys[8] = {0};
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            keys[0] = (keys[0] << 2) | cell_code(board[r][c]);
+            keys[1] = (keys[1] << 2) | cell_code(board[n - c][r]);
+            keys[2] = (keys[2] << 2) | cell_code(board[n - r][n - c]);
+            keys[3] = (keys[3] << 2) | cell_code(board[c][n - r]);
+            keys[4] = (keys[4] << 2) | cell_code(board[r][n - c]);
+            keys[5] = (keys[5] << 2) | cell_code(board[n - r][c]);
+            keys[6] = (keys[6] << 2) | cell_code(board[c][r]);
+            keys[7] = (keys[7] << 2) | cell_code(board[n - c][n - r]);
+        }
+    }
+
+    uint64_t key = keys[0];
+    for (int i = 1; i < 8; i++) {
+        if (keys[i] < key) key = keys[i];
+    }
+    return key;
+}
+
+static CacheSlot* cache_slot(uint64_t key) {
+    return &cache[(key * 0x9E3779B97F4A7C15ull) >> (64 - CACHE_BITS)];
+}
+
+/**
+ * Look up a position in the cache. An entry is usable if it was searched at least
+ * as deep as we need, or if its value is exact.
+ *
+ * \return Non-zero and fill in score/exact on a hit, 0 on a miss
+ */
+static int cache_lookup(uint64_t key, int depth, int* score, int* exact) {
+    CacheSlot* slot = cache_slot(key);
+    uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cache_lookups, 1, memory_order_relaxed);
+
+    if (!(data & ENTRY_VALID) || (check ^ data) != key) return 0;
+
+    int entry_exact = (data & ENTRY_EXACT) != 0;
+    int entry_depth = (int)((data >> ENTRY_DEPTH_SHIFT) & 0xff);
+    if (!entry_exact && entry_depth < depth) return 0;
+
+    atomic_fetch_add_explicit(&cache_hits, 1, memory_order_relaxed);
+    *score = (int)(data & 0xffff) - ENTRY_SCORE_BIAS;
+    *exact = entry_exact;
+    return 1;
+}
+
+// Store a position's value in the cache, replacing whatever was in the slot
+static void cache_store(uint64_t key, int depth, int score, int exact) {
+    uint64_t data = ENTRY_VALID | (exact ? ENTRY_EXACT : 0) |
+                    ((uint64_t)depth << ENTRY_DEPTH_SHIFT) |
+                    (uint64_t)(score + ENTRY_SCORE_BIAS);
+    CacheSlot* slot = cache_slot(key);
+    atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+    atomic_store_explicit(&slot->check, key ^ data, memory_order_relaxed);
+}
+
+/**
+ * Estimate an unfinished position for the player to move: each line that only
+ * one player has marks in counts for that player, weighted by how many marks.
+ */
+static int heuristic(char board[BOARD_SIZE][BOARD_SIZE], char me) {
+    int score = 0;
+    for (int line = 0; line < 2 * BOARD_SIZE + 2; line++) {
+        int mine = 0, theirs = 0;
+        for (int k = 0; k < BOARD_SIZE; k++) {
+            char c;
+            if (line < BOARD_SIZE) c = board[line][k];
+            else if (line < 2 * BOARD_SIZE) c = board[k][line - BOARD_SIZE];
+            else if (line == 2 * BOARD_SIZE) c = board[k][k];
+            else c = board[k][BOARD_SIZE - 1 - k];
+
+            if (c == me) mine++;
+            else if (c != ' ') theirs++;
+        }
+        if (theirs == 0) score += mine;
+        if (mine == 0) score -= theirs;
+    }
+    return score;
+}
+
+// Move a forced win or loss one step further away, since it now takes one more move
+static int back_up(int score) {
+    if (SOLVER_IS_WIN(score)) return score - 1;
+    if (SOLVER_IS_LOSS(score)) return score + 1;
+    return score;
+}
+
+/**
+ * Negamax search. Scores are relative to the player to move at this node, which
+ * is what makes them safe to share between positions reached in different ways.
+ */
+static int search(char board[BOARD_SIZE][BOARD_SIZE], char me, int depth, int* exact) {
+    // The previous player just moved, so a completed line means we lost
+    if (check_winner(board)) {
+        *exact = 1;
+        return -SOLVER_WIN;
+    }
+    if (board_is_full(board)) {
+        *exact = 1;
+        return 0;
+    }
+    if (depth == 0) {
+        *exact = 0;
+        return heuristic(board, me);
+    }
+
+    uint64_t key = canonical_key(board);
+    int score;
+    if (cache_lookup(key, depth, &score, exact)) return score;
+
+    char them = (me == 'X') ? 'O' : 'X';
+    int best = -SOLVER_WIN - 1;
+    int all_exact = 1;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (board[r][c] != ' ') continue;
+
+            int child_exact;
+            board[r][c] = me;
+            score = back_up(-search(board, them, depth - 1, &child_exact));
+            board[r][c] = ' ';
+
+            if (score > best) best = score;
+            all_exact &= child_exact;
+        }
+    }
+
+    cache_store(key, depth, best, all_exact);
+    *exact = all_exact;
+    return best;
+}
+
+// Find the best move for the player to move.
+SolverResult solver_evaluate(char board[BOARD_SIZE][BOARD_SIZE]) {
+    SolverResult result = {.row = -1, .col = -1, .score = 0, .exact = 1};
+
+    // Work on a copy so callers can pass a board other threads may be reading
+    char scratch[BOARD_SIZE][BOARD_SIZE];
+    int marks = 0;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            scratch[r][c] = board[r][c];
+            if (board[r][c] != ' ') marks++;
+        }
+    }
+    char me = (marks % 2 == 0) ? 'X' : 'O';
+    char them = (me == 'X') ? 'O' : 'X';
+
+    int winner = check_winner(scratch);
+    if (winner) {
+        result.score = (winner == me) ? SOLVER_WIN : -SOLVER_WIN;
+        return result;
+    }
+
+    int best = -SOLVER_WIN - 1;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (scratch[r][c] != ' ') continue;
+
+            int child_exact;
+            scratch[r][c] = me;
+            int score = back_up(-search(scratch, them, SOLVER_MAX_DEPTH - 1, &child_exact));
+            scratch[r][c] = ' ';
+
+            if (score > best) {
+                best = score;
+                result.row = r;
+                result.col = c;
+            }
+            result.exact &= child_exact;
+        }
+    }
+
+    // A full board with no winner is a draw and leaves best untouched
+    if (result.row != -1) result.score = best;
+    return result;
+}
+
+// Read the transposition cache counters.
+void solver_cache_stats(unsigned long* lookups, unsigned long* hits) {
+    *lookups = atomic_load_explicit(&cache_lookups, memory_order_relaxed);
+    *hits = atomic_load_explicit(&cache_hits, memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "game.h"
+
+// Scores at or above this magnitude mean one side can force a win. The score
+// shrinks by one for every move needed, so faster wins score higher.
+#define SOLVER_WIN 1000
+#define SOLVER_IS_WIN(score) ((score) > SOLVER_WIN - BOARD_SIZE * BOARD_SIZE - 1)
+#define SOLVER_IS_LOSS(score) ((score) < -(SOLVER_WIN - BOARD_SIZE * BOARD_SIZE - 1))
+
+// The 3x3 board is small enough to solve outright. Larger boards fall back to a
+// depth-limited search that scores unfinished positions by their open lines.
+#if BOARD_SIZE <= 3
+#define SOLVER_MAX_DEPTH (BOARD_SIZE * BOARD_SIZE)
+#else
+#define SOLVER_MAX_DEPTH 5
+#endif
+
+/**
+ * The result of evaluating a position for the player whose turn it is.
+ * - row, col: The best move (0-based), or -1 if the game is already over
+ * - score: Positive if the player to move is ahead, negative if behind, 0 for a draw
+ * - exact: Non-zero if the score is the game-theoretic value rather than an estimate
+ */
+typedef struct {
+    int row;
+    int col;
+    int score;
+    int exact;
+} SolverResult;
+
+/**
+ * Find the best move for the player to move (X moves first, so this is decided
+ * by counting marks). Evaluations are memoized in a transposition cache that is
+ * shared by every thread and keyed by the board's symmetry-reduced form, so a
+ * position that shows up in many games is only searched once.
+ *
+ * \param board The current game board
+ * \return The best move and the value of the position
+ */
+SolverResult solver_evaluate(char board[BOARD_SIZE][BOARD_SIZE]);
+
+/**
+ * Read the transposition cache counters.
+ *
+ * \param lookups Set to the number of cache lookups performed so far
+ * \param hits Set to the number of lookups that found a usable entry
+ */
+void solver_cache_stats(unsigned long* lookups, unsigned long* hits);